@@ -0,0 +1,109 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/NumberParser.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lxml;
+
+static const std::size_t kValueCount = 1000000;
+static const int kRepetitions = 5;
+
+/**
+ Time `function` over all values and return the best run in nanoseconds
+ per value.
+ */
+template <typename F>
+static double measure(const std::vector<std::string>& values, F function) {
+    double best = 0;
+    for (int i = 0; i < kRepetitions; i += 1) {
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& value : values)
+            function(value);
+        auto end = std::chrono::steady_clock::now();
+        
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / values.size();
+        if (i == 0 || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+static void report(const char* name, double before, double after) {
+    std::printf("%-8s strto*: %6.2f ns  parseNumber: %6.2f ns  speedup: %.2fx\n", name, before, after, before / after);
+}
+
+int main() {
+    std::mt19937_64 random(42);
+    std::vector<std::string> integers;
+    std::vector<std::string> doubles;
+    for (std::size_t i = 0; i < kValueCount; i += 1) {
+        // Element contents as the recursive handlers used to receive them
+        std::int64_t integer = static_cast<std::int64_t>(random() % 2000000000) - 1000000000;
+        integers.push_back("  " + std::to_string(integer) + "\n");
+        
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), " %.6f ", std::uniform_real_distribution<double>(-1e6, 1e6)(random));
+        doubles.push_back(buffer);
+    }
+    
+    volatile std::int64_t integerSink = 0;
+    volatile double doubleSink = 0;
+    
+    double before = measure(integers, [&](const std::string& value) {
+        integerSink = (int)strtol(value.c_str(), NULL, 10);
+    });
+    double after = measure(integers, [&](const std::string& value) {
+        std::int32_t result = 0;
+        parseNumber(value, result);
+        integerSink = result;
+    });
+    report("int32", before, after);
+    
+    before = measure(integers, [&](const std::string& value) {
+        integerSink = strtoll(value.c_str(), NULL, 10);
+    });
+    after = measure(integers, [&](const std::string& value) {
+        std::int64_t result = 0;
+        parseNumber(value, result);
+        integerSink = result;
+    });
+    report("int64", before, after);
+    
+    before = measure(doubles, [&](const std::string& value) {
+        doubleSink = strtod(value.c_str(), NULL);
+    });
+    after = measure(doubles, [&](const std::string& value) {
+        double result = 0;
+        parseNumber(value, result);
+        doubleSink = result;
+    });
+    report("double", before, after);
+    
+    return 0;
+}
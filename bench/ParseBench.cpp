@@ -0,0 +1,563 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/BaseRecursiveHandler.h>
+#include <lxml/DoubleHandler.h>
+#include <lxml/EventTape.h>
+#include <lxml/FlatDocument.h>
+#include <lxml/IntegerHandler.h>
+#include <lxml/ListHandler.h>
+#include <lxml/StringHandler.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <libxml/xmlmemory.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace lxml;
+
+// Allocation counters. C++ allocations are counted by replacing the global
+// operator new, libxml2's through xmlMemSetup.
+static std::atomic<std::uint64_t> __allocations(0);
+static std::atomic<std::uint64_t> __allocatedBytes(0);
+
+static void countAllocation(std::size_t size) {
+    __allocations.fetch_add(1, std::memory_order_relaxed);
+    __allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+// Bytes of C++ allocations currently live, as malloc rounds them
+static std::atomic<std::int64_t> __liveBytes(0);
+
+void* operator new(std::size_t size) {
+    countAllocation(size);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        __liveBytes.fetch_add(malloc_usable_size(pointer), std::memory_order_relaxed);
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer)
+        __liveBytes.fetch_sub(malloc_usable_size(pointer), std::memory_order_relaxed);
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    operator delete(pointer);
+}
+
+// Where libxml2's allocations go after being counted, malloc or
+// XmlMemoryPool with --pool
+static void* (*__malloc)(std::size_t) = std::malloc;
+static void* (*__realloc)(void*, std::size_t) = std::realloc;
+static void (*__free)(void*) = std::free;
+
+static void* countingMalloc(std::size_t size) {
+    countAllocation(size);
+    return __malloc(size);
+}
+
+static void* countingRealloc(void* pointer, std::size_t size) {
+    countAllocation(size);
+    return __realloc(pointer, size);
+}
+
+static void countingFree(void* pointer) {
+    __free(pointer);
+}
+
+static char* countingStrdup(const char* string) {
+    std::size_t size = std::strlen(string) + 1;
+    countAllocation(size);
+    char* copy = static_cast<char*>(__malloc(size));
+    std::memcpy(copy, string, size);
+    return copy;
+}
+
+static long peakRSSKilobytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+
+// Document generators, each appends records until the document reaches
+// the requested size
+
+typedef std::function<void(std::string& xml, std::size_t index, std::mt19937& random)> RecordGenerator;
+
+static std::string generate(const char* open, const char* close, std::size_t size, RecordGenerator record) {
+    std::mt19937 random(42);
+    std::string xml = open;
+    for (std::size_t i = 0; xml.size() < size; ++i)
+        record(xml, i, random);
+    xml += close;
+    return xml;
+}
+
+static std::string word(std::mt19937& random) {
+    static const char* kWords[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do"};
+    return kWords[random() % 10];
+}
+
+static std::string deepDocument(std::size_t size) {
+    // Chains of 64 nested elements
+    return generate("<root>", "</root>", size, [](std::string& xml, std::size_t, std::mt19937&) {
+        for (int depth = 0; depth < 64; ++depth)
+            xml += "<level d='" + std::to_string(depth) + "'>";
+        xml += "leaf";
+        for (int depth = 0; depth < 64; ++depth)
+            xml += "</level>";
+    });
+}
+
+static std::string wideDocument(std::size_t size) {
+    return generate("<root>", "</root>", size, [](std::string& xml, std::size_t index, std::mt19937&) {
+        xml += "<item>" + std::to_string(index) + "</item>";
+    });
+}
+
+static std::string attributeDocument(std::size_t size) {
+    return generate("<root>", "</root>", size, [](std::string& xml, std::size_t index, std::mt19937& random) {
+        xml += "<item";
+        for (int i = 0; i < 12; ++i)
+            xml += " a" + std::to_string(i) + "='" + word(random) + std::to_string(index) + "'";
+        xml += "/>";
+    });
+}
+
+static std::string textDocument(std::size_t size) {
+    return generate("<root>", "</root>", size, [](std::string& xml, std::size_t, std::mt19937& random) {
+        xml += "<p>";
+        for (int i = 0; i < 200; ++i)
+            xml += word(random) + (i % 17 == 16 ? "\n  " : " ");
+        xml += "</p>";
+    });
+}
+
+static std::string numericDocument(std::size_t size) {
+    return generate("<values>", "</values>", size, [](std::string& xml, std::size_t, std::mt19937& random) {
+        xml += "<v>" + std::to_string(static_cast<int>(random() % 2000000) - 1000000) + "</v>";
+    });
+}
+
+static std::string namespaceDocument(std::size_t size) {
+    return generate("<root xmlns='urn:default' xmlns:a='urn:a' xmlns:b='urn:b'>", "</root>", size, [](std::string& xml, std::size_t index, std::mt19937&) {
+        xml += "<a:record xmlns:c='urn:c' b:id='" + std::to_string(index) + "'><b:name>n</b:name><c:value a:unit='m'>1</c:value><plain/></a:record>";
+    });
+}
+
+
+// Handlers
+
+/**
+ Counts events through virtual dispatch.
+ */
+class CountingSAXHandler : public SAXHandler {
+public:
+    std::size_t elements = 0;
+    std::size_t attributes = 0;
+    std::size_t textBytes = 0;
+    
+public:
+    void startDocument() {}
+    void endDocument() {}
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributeView) {
+        ++elements;
+        attributes += attributeView.size();
+    }
+    void endElement(const QName& qname) {}
+    void characters(const char* chars, std::size_t length) {
+        textBytes += length;
+    }
+    void error(const xmlError& error) {}
+};
+
+/**
+ Counts events through static dispatch.
+ */
+struct CountingStaticHandler {
+    std::size_t elements = 0;
+    
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        ++elements;
+    }
+    void characters(const char* chars, std::size_t length) {}
+};
+
+/**
+ A recursive handler that handles every element with itself and keeps its
+ text, the way a generic tree builder would.
+ */
+class NodeHandler : public BaseRecursiveHandler<std::size_t> {
+public:
+    void startElement(const QName& qname, const AttributeView& attributes) {
+        _result = 0;
+    }
+    void endElement(const QName& qname, std::string_view contents) {
+        _result += contents.size();
+    }
+    RecursiveHandler* startSubElement(const QName& qname) {
+        return this;
+    }
+};
+
+/**
+ Builds the README's example tree, a node object per element with its name,
+ text and owned children.
+ */
+class TreeHandler : public SAXHandler {
+public:
+    struct Node {
+        std::string name;
+        std::string text;
+        Node* parent;
+        std::vector<std::unique_ptr<Node>> children;
+    };
+    
+    std::unique_ptr<Node> root;
+    
+public:
+    void startDocument() {
+        root.reset();
+        _current = 0;
+    }
+    void endDocument() {}
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        std::unique_ptr<Node> node(new Node{qname.localName(), std::string(), _current, {}});
+        Node* added = node.get();
+        if (_current)
+            _current->children.push_back(std::move(node));
+        else
+            root = std::move(node);
+        _current = added;
+    }
+    void endElement(const QName& qname) {
+        _current = _current->parent;
+    }
+    void characters(const char* chars, std::size_t length) {
+        if (_current)
+            _current->text.append(chars, length);
+    }
+    void error(const xmlError& error) {}
+    
+private:
+    Node* _current = 0;
+};
+
+
+// Benchmark cases
+
+struct Result {
+    std::string document;
+    std::string handler;
+    std::size_t bytes;
+    std::size_t elements;
+    double seconds;
+    std::uint64_t allocations;
+    std::uint64_t allocatedBytes;
+    std::int64_t keptBytes;
+    long peakRSS;
+    bool success;
+    ParseStats stats;
+};
+
+struct Options {
+    std::size_t size = 16*1024*1024;
+    int repetitions = 5;
+    std::string json;
+    std::string filter;
+    bool stats = false;
+    bool pool = false;
+};
+
+typedef std::function<bool(Parser& parser, const std::string& xml)> ParseFunction;
+
+// Live bytes when the current run started and what a document builder
+// still held when its parse ended
+static std::int64_t __runLiveBytes = 0;
+static std::int64_t __keptBytes = 0;
+
+static void recordKeptBytes() {
+    __keptBytes = __liveBytes.load() - __runLiveBytes;
+}
+
+/**
+ Parse a document several times and keep the fastest run. Allocations are
+ those of the last run, once pooled buffers have warmed up.
+ */
+static Result run(const Options& options, const std::string& documentName, const std::string& xml, std::size_t elements, const std::string& handlerName, ParseFunction parse) {
+    Result result = {documentName, handlerName, xml.size(), elements, 0, 0, 0, 0, 0, true, ParseStats()};
+    ParseOptions parseOptions;
+    parseOptions.collectStats = options.stats;
+    Parser parser(parseOptions);
+    for (int i = 0; i < options.repetitions; ++i) {
+        std::uint64_t allocations = __allocations.load();
+        std::uint64_t allocatedBytes = __allocatedBytes.load();
+        __runLiveBytes = __liveBytes.load();
+        __keptBytes = 0;
+        
+        auto start = std::chrono::steady_clock::now();
+        result.success = parse(parser, xml) && result.success;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        result.allocations = __allocations.load() - allocations;
+        result.allocatedBytes = __allocatedBytes.load() - allocatedBytes;
+        result.keptBytes = __keptBytes;
+        if (i == 0 || seconds < result.seconds) {
+            result.seconds = seconds;
+            result.stats = parser.stats();
+        }
+    }
+    result.peakRSS = peakRSSKilobytes();
+    return result;
+}
+
+static void print(const Options& options, const Result& result) {
+    std::printf("%-10s %-16s %8.1f MB/s %8.2f Mev/s %8.3f alloc/elem %9ld KB peak",
+                result.document.c_str(), result.handler.c_str(),
+                result.bytes / result.seconds / 1e6,
+                result.elements / result.seconds / 1e6,
+                static_cast<double>(result.allocations) / result.elements,
+                result.peakRSS);
+    if (result.keptBytes > 0)
+        std::printf(" %7.1f B/elem kept", static_cast<double>(result.keptBytes) / result.elements);
+    if (options.stats)
+        std::printf(" %5.1f%% in handlers", 100 * result.stats.handlerSeconds / result.stats.parseSeconds);
+    std::printf("%s\n", result.success ? "" : "  FAILED");
+}
+
+static void writeJSON(const Options& options, const std::vector<Result>& results) {
+    std::FILE* file = options.json == "-" ? stdout : std::fopen(options.json.c_str(), "w");
+    if (!file) {
+        std::fprintf(stderr, "Can't write %s\n", options.json.c_str());
+        return;
+    }
+    
+    std::fprintf(file, "{\n  \"benchmark\": \"lxml_bench\",\n  \"documentSize\": %zu,\n  \"repetitions\": %d,\n  \"results\": [\n",
+                 options.size, options.repetitions);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        std::fprintf(file, "    {\"document\": \"%s\", \"handler\": \"%s\", \"bytes\": %zu, \"elements\": %zu, "
+                     "\"seconds\": %.6f, \"mbPerSecond\": %.2f, \"eventsPerSecond\": %.0f, "
+                     "\"allocations\": %llu, \"allocatedBytes\": %llu, \"allocationsPerElement\": %.4f, "
+                     "\"keptBytes\": %lld, \"peakRSSKilobytes\": %ld, \"success\": %s",
+                     result.document.c_str(), result.handler.c_str(), result.bytes, result.elements,
+                     result.seconds, result.bytes / result.seconds / 1e6, result.elements / result.seconds,
+                     static_cast<unsigned long long>(result.allocations), static_cast<unsigned long long>(result.allocatedBytes),
+                     static_cast<double>(result.allocations) / result.elements,
+                     static_cast<long long>(result.keptBytes), result.peakRSS, result.success ? "true" : "false");
+        if (options.stats) {
+            const ParseStats& stats = result.stats;
+            std::fprintf(file, ", \"stats\": {\"chunks\": %zu, \"attributes\": %zu, \"textBytes\": %zu, \"maxDepth\": %zu, "
+                         "\"libxmlSeconds\": %.6f, \"handlerSeconds\": %.6f, \"contentAllocations\": %zu}",
+                         stats.chunks, stats.attributes, stats.textBytes, stats.maxDepth,
+                         stats.libxmlSeconds(), stats.handlerSeconds, stats.contentAllocations);
+        }
+        std::fprintf(file, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    if (file != stdout)
+        std::fclose(file);
+}
+
+static void usage() {
+    std::fprintf(stderr,
+                 "usage: lxml_bench [--size MB] [--repetitions N] [--json FILE|-] [--filter DOCUMENT] [--stats] [--pool]\n"
+                 "Parses synthetic documents (deep, wide, attributes, text, numeric, namespaces)\n"
+                 "with several handlers and reports throughput, allocations and peak RSS.\n"
+                 "--stats parses with ParseOptions::collectStats and reports the ParseStats.\n"
+                 "--pool serves libxml2's allocations from XmlMemoryPool instead of malloc.\n");
+}
+
+static bool parseArguments(int argc, const char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--stats") {
+            options.stats = true;
+            continue;
+        }
+        if (argument == "--pool") {
+            options.pool = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return false;
+        if (argument == "--size")
+            options.size = std::strtoul(argv[++i], NULL, 10) * 1024 * 1024;
+        else if (argument == "--repetitions")
+            options.repetitions = std::atoi(argv[++i]);
+        else if (argument == "--json")
+            options.json = argv[++i];
+        else if (argument == "--filter")
+            options.filter = argv[++i];
+        else
+            return false;
+    }
+    return options.size > 0 && options.repetitions > 0;
+}
+
+/**
+ A file in the system's temporary directory, removed when it goes out of
+ scope.
+ */
+struct TemporaryFile {
+    std::string path;
+    
+    explicit TemporaryFile(const std::string& name) : path((std::filesystem::temp_directory_path() / name).string()) {}
+    ~TemporaryFile() {
+        std::remove(path.c_str());
+    }
+};
+
+int main(int argc, const char* argv[]) {
+    // Must come before libxml2 allocates anything
+    xmlMemSetup(countingFree, countingMalloc, countingRealloc, countingStrdup);
+    
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        usage();
+        return 1;
+    }
+    if (options.pool) {
+        // The pool leaves memory allocated before it to malloc
+        __malloc = XmlMemoryPool::allocate;
+        __realloc = XmlMemoryPool::reallocate;
+        __free = XmlMemoryPool::free;
+    }
+    
+    struct Document {
+        const char* name;
+        std::string (*generate)(std::size_t size);
+    };
+    const Document documents[] = {
+        {"deep", deepDocument},
+        {"wide", wideDocument},
+        {"attributes", attributeDocument},
+        {"text", textDocument},
+        {"numeric", numericDocument},
+        {"namespaces", namespaceDocument},
+    };
+    
+    TemporaryFile tapeFile("lxml_bench-" + std::to_string(getpid()) + ".tape");
+    std::vector<Result> results;
+    auto add = [&](const Result& result) {
+        if (options.json != "-")
+            print(options, result);
+        results.push_back(result);
+    };
+    
+    for (const Document& document : documents) {
+        if (!options.filter.empty() && options.filter != document.name)
+            continue;
+        
+        std::string xml = document.generate(options.size);
+        CountingSAXHandler counter;
+        parse(xml.data(), xml.size(), document.name, counter);
+        std::size_t elements = counter.elements;
+        
+        add(run(options, document.name, xml, elements, "sax", [](Parser& parser, const std::string& xml) {
+            CountingSAXHandler handler;
+            return parser.parse(xml.data(), xml.size(), "bench.xml", handler);
+        }));
+        add(run(options, document.name, xml, elements, "static", [](Parser& parser, const std::string& xml) {
+            CountingStaticHandler handler;
+            return parser.parse(xml.data(), xml.size(), "bench.xml", handler);
+        }));
+        add(run(options, document.name, xml, elements, "recursive", [](Parser& parser, const std::string& xml) {
+            NodeHandler handler;
+            return parser.parse(xml.data(), xml.size(), "bench.xml", handler);
+        }));
+        
+        // Replaying a tape recorded once, throughput is relative to the XML
+        EventTape tape;
+        if (EventTape::record(xml.data(), xml.size(), tapeFile.path) && tape.open(tapeFile.path)) {
+            add(run(options, document.name, xml, elements, "tape", [&](Parser&, const std::string&) {
+                CountingSAXHandler handler;
+                return tape.replay(handler);
+            }));
+            tape.close();
+        }
+        
+        // Document builders, reporting the memory their document keeps
+        add(run(options, document.name, xml, elements, "tree", [](Parser& parser, const std::string& xml) {
+            TreeHandler handler;
+            bool success = parser.parse(xml.data(), xml.size(), "bench.xml", handler);
+            recordKeptBytes();
+            return success;
+        }));
+        add(run(options, document.name, xml, elements, "flat", [](Parser& parser, const std::string& xml) {
+            FlatDocumentBuilder handler;
+            bool success = parser.parse(xml.data(), xml.size(), "bench.xml", handler);
+            recordKeptBytes();
+            return success;
+        }));
+        
+        // Leaf handlers on the documents that fit them
+        std::string name = document.name;
+        if (name == "text" || name == "wide") {
+            add(run(options, document.name, xml, elements, "list<string>", [](Parser& parser, const std::string& xml) {
+                StringHandler item;
+                ListHandler<std::string> handler(item);
+                return parser.parse(xml.data(), xml.size(), "bench.xml", handler);
+            }));
+        }
+        if (name == "numeric" || name == "wide") {
+            add(run(options, document.name, xml, elements, "list<integer>", [](Parser& parser, const std::string& xml) {
+                IntegerHandler item;
+                ListHandler<int> handler(item);
+                return parser.parse(xml.data(), xml.size(), "bench.xml", handler);
+            }));
+            add(run(options, document.name, xml, elements, "list<double>", [](Parser& parser, const std::string& xml) {
+                DoubleHandler item;
+                ListHandler<double> handler(item);
+                return parser.parse(xml.data(), xml.size(), "bench.xml", handler);
+            }));
+        }
+    }
+    
+    if (!options.json.empty())
+        writeJSON(options, results);
+    
+    for (const Result& result : results) {
+        if (!result.success)
+            return 1;
+    }
+    return 0;
+}
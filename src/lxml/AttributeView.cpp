@@ -0,0 +1,93 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "AttributeView.h"
+#include "NumberParser.h"
+#include "ParseContext.h"
+#include "ParseStats.h"
+#include "Whitespace.h"
+
+namespace lxml {
+
+AttributeView::Iterator AttributeView::find(const QName& qname) const {
+    Iterator it = begin();
+    Iterator last = end();
+    for (; it != last; ++it) {
+        if ((*it).qname() == qname)
+            break;
+    }
+    return it;
+}
+
+std::string_view AttributeView::get(const QName& qname, std::string_view defaultValue) const {
+    Iterator it = find(qname);
+    if (it == end())
+        return defaultValue;
+    return (*it).value();
+}
+
+int AttributeView::getInt(const QName& qname, int defaultValue) const {
+    Iterator it = find(qname);
+    int value;
+    if (it == end() || parseNumber((*it).value(), value) != NumberStatus::Ok)
+        return defaultValue;
+    return value;
+}
+
+double AttributeView::getDouble(const QName& qname, double defaultValue) const {
+    Iterator it = find(qname);
+    double value;
+    if (it == end() || parseNumber((*it).value(), value) != NumberStatus::Ok)
+        return defaultValue;
+    return value;
+}
+
+bool AttributeView::getBool(const QName& qname, bool defaultValue) const {
+    Iterator it = find(qname);
+    if (it == end())
+        return defaultValue;
+
+    std::string_view value = trim((*it).value());
+    if (value == "true" || value == "1")
+        return true;
+    if (value == "false" || value == "0")
+        return false;
+    return defaultValue;
+}
+
+AttributeView::Map AttributeView::toMap() const {
+    Map map;
+    for (Attribute attribute : *this)
+        map[attribute.qname()] = std::string(attribute.value());
+    
+    if (ParseContext* context = ParseContext::current()) {
+        if (ParseStats* stats = context->stats()) {
+            // A node per attribute, and values that don't fit in place
+            static const std::size_t kInPlaceCapacity = std::string().capacity();
+            stats->attributeMapAllocations += map.size();
+            for (const auto& entry : map)
+                stats->attributeMapAllocations += entry.second.size() > kInPlaceCapacity;
+        }
+    }
+    return map;
+}
+
+} // namespace lxml
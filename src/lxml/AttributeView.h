@@ -0,0 +1,188 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "QName.h"
+#include "SymbolTable.h"
+
+#include <libxml/parser.h>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace lxml {
+
+/**
+ Attribute is a lightweight reference to an attribute in libxml2's
+ attribute array. It is only valid for the duration of the callback it was
+ delivered to.
+ */
+class Attribute {
+public:
+    explicit Attribute(const xmlChar** attribute, const SymbolTable* symbols = 0) : _attribute(attribute), _symbols(symbols) {}
+
+    QName qname() const {
+        if (_symbols)
+            return _symbols->qname(localName(), prefix(), namespaceURI());
+        return QName(localName(), prefix(), namespaceURI());
+    }
+    const char* localName() const {
+        return reinterpret_cast<const char*>(_attribute[0]);
+    }
+    const char* prefix() const {
+        return reinterpret_cast<const char*>(_attribute[1]);
+    }
+    const char* namespaceURI() const {
+        return reinterpret_cast<const char*>(_attribute[2]);
+    }
+
+    /**
+     The attribute value. It points into libxml2's buffer and is not null
+     terminated.
+     */
+    std::string_view value() const {
+        const char* first = reinterpret_cast<const char*>(_attribute[3]);
+        const char* last = reinterpret_cast<const char*>(_attribute[4]);
+        return std::string_view(first, static_cast<std::size_t>(last - first));
+    }
+
+private:
+    const xmlChar** _attribute;
+    const SymbolTable* _symbols;
+};
+
+/**
+ AttributeView is a non-owning range over the attributes of an element as
+ reported by libxml2. Constructing, iterating and querying a view never
+ allocates. Views are only valid for the duration of the callback they
+ were delivered to; use `toMap` to keep a copy.
+ */
+class AttributeView {
+public:
+    typedef std::map<QName, std::string> Map;
+
+    class Iterator {
+    public:
+        Iterator(const xmlChar** attribute, const SymbolTable* symbols) : _attribute(attribute), _symbols(symbols) {}
+
+        Attribute operator*() const {
+            return Attribute(_attribute, _symbols);
+        }
+        Iterator& operator++() {
+            _attribute += kAttributeStride;
+            return *this;
+        }
+        bool operator==(const Iterator& it) const {
+            return _attribute == it._attribute;
+        }
+        bool operator!=(const Iterator& it) const {
+            return _attribute != it._attribute;
+        }
+
+    private:
+        const xmlChar** _attribute;
+        const SymbolTable* _symbols;
+    };
+
+public:
+    AttributeView() : _attributes(), _count(), _symbols() {}
+    
+    /**
+     @param attributes libxml2's attribute array, five pointers per
+                       attribute.
+     @param count      The number of attributes.
+     @param symbols    The SymbolTable the parser used, if any, to intern
+                       the names registered in it.
+     */
+    AttributeView(const xmlChar** attributes, int count, const SymbolTable* symbols = 0)
+    : _attributes(attributes), _count(static_cast<std::size_t>(count)), _symbols(symbols) {}
+
+    std::size_t size() const {
+        return _count;
+    }
+    bool empty() const {
+        return _count == 0;
+    }
+
+    Attribute operator[](std::size_t index) const {
+        return Attribute(_attributes + index * kAttributeStride, _symbols);
+    }
+    Iterator begin() const {
+        return Iterator(_attributes, _symbols);
+    }
+    Iterator end() const {
+        return Iterator(_attributes + _count * kAttributeStride, _symbols);
+    }
+
+    /**
+     Find an attribute by qualified name. This is a linear search, elements
+     rarely have more than a handful of attributes.
+
+     @return An iterator to the attribute or `end()` if there is no
+             attribute with the given name.
+     */
+    Iterator find(const QName& qname) const;
+
+    bool contains(const QName& qname) const {
+        return find(qname) != end();
+    }
+
+    /**
+     Get the value of an attribute or `defaultValue` if the attribute is
+     not present.
+     */
+    std::string_view get(const QName& qname, std::string_view defaultValue = std::string_view()) const;
+
+    /**
+     Get the value of an attribute parsed as an integer. Returns
+     `defaultValue` if the attribute is not present or is not a valid
+     integer.
+     */
+    int getInt(const QName& qname, int defaultValue = 0) const;
+
+    /**
+     Get the value of an attribute parsed as a double. Returns
+     `defaultValue` if the attribute is not present or is not a valid
+     number.
+     */
+    double getDouble(const QName& qname, double defaultValue = 0) const;
+
+    /**
+     Get the value of an attribute parsed as an XML Schema boolean (`true`,
+     `false`, `1` or `0`). Returns `defaultValue` if the attribute is not
+     present or is not a valid boolean.
+     */
+    bool getBool(const QName& qname, bool defaultValue = false) const;
+
+    /**
+     Copy the attributes into a map.
+     */
+    Map toMap() const;
+
+private:
+    static const std::size_t kAttributeStride = 5;
+
+    const xmlChar** _attributes;
+    std::size_t _count;
+    const SymbolTable* _symbols;
+};
+
+} // namespace lxml
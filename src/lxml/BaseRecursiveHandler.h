@@ -44,11 +44,11 @@ public:
         _result = T();
     }
     
-    virtual void startElement(const QName& qname, const AttributeMap& attributes) {
+    virtual void startElement(const QName& qname, const AttributeView& attributes) {
         
     }
     
-    virtual void endElement(const QName& qname, const std::string& contents) {
+    virtual void endElement(const QName& qname, std::string_view contents) {
         
     }
     
@@ -0,0 +1,99 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "BatchParser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <libxml/parser.h>
+#include <numeric>
+#include <sys/stat.h>
+
+namespace lxml {
+
+static std::size_t documentSize(const Document& document) {
+    if (document.path.empty())
+        return document.length;
+
+    struct stat status;
+    if (stat(document.path.c_str(), &status) != 0)
+        return 0;
+    return static_cast<std::size_t>(status.st_size);
+}
+
+BatchParser::BatchParser(const BatchOptions& options) : _options(options), _pool(options.threads) {
+    // libxml2 must be initialized before threads use it
+    xmlInitParser();
+    _parsers.resize(_pool.size());
+}
+
+std::vector<DocumentResult> BatchParser::run(const std::vector<Document>& documents, const ParseFunction& parse) {
+    std::vector<DocumentResult> results(documents.size());
+    for (std::size_t i = 0; i < documents.size(); i += 1)
+        results[i].size = documentSize(documents[i]);
+
+    // Largest first, workers take from the front of their queues and steal
+    // the smaller documents from the back of others
+    std::vector<std::size_t> order(documents.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return results[a].size > results[b].size;
+    });
+
+    // An exception must not escape a pool thread. Keep the first one, skip
+    // the documents that haven't started and rethrow it here.
+    std::mutex mutex;
+    std::exception_ptr exception;
+
+    for (std::size_t index : order) {
+        _pool.submit([this, &documents, &results, &parse, &mutex, &exception, index]() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (exception)
+                    return;
+            }
+
+            std::unique_ptr<Parser>& parser = _parsers[ThreadPool::currentIndex()];
+            auto start = std::chrono::steady_clock::now();
+            try {
+                if (!parser)
+                    parser.reset(new Parser(_options.parseOptions));
+                results[index].success = parse(*parser, documents[index], index);
+            } catch (...) {
+                // The parser may have been left in the middle of a document
+                parser.reset();
+                results[index].success = false;
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!exception)
+                    exception = std::current_exception();
+            }
+            results[index].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        });
+    }
+    _pool.wait();
+
+    if (exception)
+        std::rethrow_exception(exception);
+    return results;
+}
+
+} // namespace lxml
@@ -0,0 +1,168 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "ParseOptions.h"
+#include "Parser.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lxml {
+
+/**
+ A document to parse in a batch, either a file or a buffer in memory.
+ */
+struct Document {
+    /// The path of a file, empty for documents in memory
+    std::string path;
+    
+    const char* data;
+    std::size_t length;
+    std::string filename;
+    
+    Document() : data(), length() {}
+    
+    static Document file(const std::string& path) {
+        Document document;
+        document.path = path;
+        document.filename = path;
+        return document;
+    }
+    
+    static Document memory(const char* data, std::size_t length, const std::string& filename) {
+        Document document;
+        document.data = data;
+        document.length = length;
+        document.filename = filename;
+        return document;
+    }
+};
+
+/**
+ The outcome of parsing one document in a batch.
+ */
+struct DocumentResult {
+    /// `true` if the document was parsed without errors
+    bool success;
+    
+    /// The size of the document in bytes
+    std::size_t size;
+    
+    /// The wall time spent parsing the document
+    double seconds;
+    
+    DocumentResult() : success(), size(), seconds() {}
+};
+
+/**
+ Options for BatchParser and parseMany.
+ */
+struct BatchOptions {
+    /// The number of worker threads, `0` for one per hardware thread
+    std::size_t threads;
+    
+    /// Options for the parser of each worker thread
+    ParseOptions parseOptions;
+    
+    BatchOptions() : threads() {}
+};
+
+/**
+ BatchParser parses many independent documents on a work-stealing
+ ThreadPool. Each worker thread keeps its own Parser for the lifetime of the
+ BatchParser. Documents are scheduled largest first so that a large
+ document picked up last does not leave the other workers idle at the end.
+ 
+ See parseMany for a version that manages handlers.
+ */
+class BatchParser {
+public:
+    typedef std::function<bool(Parser& parser, const Document& document, std::size_t index)> ParseFunction;
+    
+public:
+    explicit BatchParser(const BatchOptions& options = BatchOptions());
+    
+    BatchParser(const BatchParser&) = delete;
+    BatchParser& operator=(const BatchParser&) = delete;
+    
+    std::size_t threadCount() const {
+        return _pool.size();
+    }
+    
+    /**
+     Call `parse` on a worker thread for every document and wait for all of
+     them. If `parse` throws, documents that haven't started are skipped and
+     the first exception is rethrown once the running ones are done.
+     
+     @return The result for each document, in the order of `documents`.
+     */
+    std::vector<DocumentResult> run(const std::vector<Document>& documents, const ParseFunction& parse);
+    
+private:
+    BatchOptions _options;
+    std::vector<std::unique_ptr<Parser>> _parsers;
+    ThreadPool _pool;
+};
+
+/**
+ Parse many documents in parallel. Each worker thread gets its own handler
+ from `makeHandler`, which it reuses for every document it parses, and calls
+ `onDocument` on that thread after each document. The handler can be any
+ handler accepted by `Parser`. An exception thrown by `makeHandler` or
+ `onDocument` is rethrown, see BatchParser::run.
+ 
+ @return The result for each document, in the order of `documents`.
+ */
+template <typename Handler>
+std::vector<DocumentResult> parseMany(const std::vector<Document>& documents,
+                                      std::function<std::unique_ptr<Handler>()> makeHandler,
+                                      std::function<void(std::size_t index, Handler& handler, bool success)> onDocument = nullptr,
+                                      const BatchOptions& options = BatchOptions()) {
+    BatchParser batch(options);
+    std::vector<std::unique_ptr<Handler>> handlers(batch.threadCount());
+    std::mutex mutex;
+    
+    return batch.run(documents, [&](Parser& parser, const Document& document, std::size_t index) {
+        std::unique_ptr<Handler>& handler = handlers[ThreadPool::currentIndex()];
+        if (!handler) {
+            std::lock_guard<std::mutex> lock(mutex);
+            handler = makeHandler();
+        }
+        
+        bool result;
+        if (document.path.empty())
+            result = parser.parse(document.data, document.length, document.filename, *handler);
+        else
+            result = parser.parseFile(document.path, *handler);
+        
+        if (onDocument)
+            onDocument(index, *handler, result);
+        return result;
+    });
+}
+
+} // namespace lxml
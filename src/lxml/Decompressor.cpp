@@ -0,0 +1,301 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "Decompressor.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <streambuf>
+
+#ifdef LXML_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef LXML_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace lxml {
+
+static const unsigned char kGzipMagic[] = {0x1f, 0x8b};
+static const unsigned char kZstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+
+// Compressed input is read from streams in blocks of this size
+static const std::size_t kCompressedBlockSize = 256*1024;
+
+/// Whether `data` starts with `magic`, or is a prefix of it if `partial`
+template <std::size_t N>
+static bool hasMagic(const char* data, std::size_t length, const unsigned char (&magic)[N], bool partial) {
+    if (length < N && !partial)
+        return false;
+    return std::memcmp(data, magic, std::min(length, N)) == 0;
+}
+
+static Compression detectHeader(const char* data, std::size_t length, bool partial) {
+    if (length == 0)
+        return Compression::None;
+    if (hasMagic(data, length, kGzipMagic, partial))
+        return Compression::Gzip;
+    if (hasMagic(data, length, kZstdMagic, partial))
+        return Compression::Zstd;
+    return Compression::None;
+}
+
+Compression detectCompression(const char* data, std::size_t length) {
+    return detectHeader(data, length, false);
+}
+
+Compression detectCompression(std::istream& is) {
+    std::streambuf* buffer = is.rdbuf();
+    if (!buffer)
+        return Compression::None;
+    std::streambuf::int_type c = buffer->sgetc();
+    if (c == std::streambuf::traits_type::eof())
+        return Compression::None;
+
+    // Take the header out of the stream's buffer and put it back, which
+    // can't fail for bytes that were in the buffer
+    char header[sizeof(kZstdMagic)];
+    std::streamsize available = std::min<std::streamsize>(buffer->in_avail(), sizeof(header));
+    if (available <= 0) {
+        header[0] = std::streambuf::traits_type::to_char_type(c);
+        return detectHeader(header, 1, true);
+    }
+    std::streamsize length = buffer->sgetn(header, available);
+    for (std::streamsize i = 0; i < length; i += 1)
+        buffer->sungetc();
+    return detectHeader(header, static_cast<std::size_t>(length), length < static_cast<std::streamsize>(sizeof(header)));
+}
+
+bool isCompressionSupported(Compression compression) {
+    switch (compression) {
+        case Compression::None:
+            return true;
+        case Compression::Gzip:
+#ifdef LXML_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Compression::Zstd:
+#ifdef LXML_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+namespace {
+
+/**
+ The compressed input of a decompressor, either a whole buffer in memory or
+ blocks read from a stream.
+ */
+class CompressedInput {
+public:
+    explicit CompressedInput(std::istream& is) : _is(&is), _buffer(new char[kCompressedBlockSize]), _data(), _length() {}
+    CompressedInput(const char* data, std::size_t length) : _is(), _data(data), _length(length) {}
+
+    /// Get more input, `false` at the end
+    bool next(const char*& data, std::size_t& length) {
+        if (_is) {
+            if (!*_is)
+                return false;
+            _is->read(_buffer.get(), kCompressedBlockSize);
+            length = static_cast<std::size_t>(_is->gcount());
+            data = _buffer.get();
+            return length > 0;
+        }
+
+        if (_length == 0)
+            return false;
+        data = _data;
+        length = _length;
+        _length = 0;
+        return true;
+    }
+
+private:
+    std::istream* _is;
+    std::unique_ptr<char[]> _buffer;
+    const char* _data;
+    std::size_t _length;
+};
+
+#ifdef LXML_HAVE_ZLIB
+
+class GzipSource : public InputSource {
+public:
+    explicit GzipSource(CompressedInput&& input)
+    : _input(std::move(input)), _next(), _remaining(), _failed(), _ended(), _memberEnded() {
+        std::memset(&_stream, 0, sizeof(_stream));
+        // Detect the gzip or zlib header automatically
+        _failed = inflateInit2(&_stream, 15 + 32) != Z_OK;
+    }
+
+    ~GzipSource() {
+        inflateEnd(&_stream);
+    }
+
+    std::size_t read(char* buffer, std::size_t size) {
+        if (_failed || _ended)
+            return 0;
+
+        _stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        _stream.avail_out = static_cast<uInt>(std::min<std::size_t>(size, UINT_MAX));
+        while (_stream.avail_out > 0) {
+            if (_stream.avail_in == 0 && !refill()) {
+                // Input that ends inside a member is truncated
+                _failed = _stream.total_in > 0 && !_memberEnded;
+                _ended = true;
+                break;
+            }
+
+            int result = inflate(&_stream, Z_NO_FLUSH);
+            _memberEnded = result == Z_STREAM_END;
+            if (result == Z_STREAM_END) {
+                // Concatenated members continue the document
+                inflateReset(&_stream);
+            } else if (result != Z_OK && result != Z_BUF_ERROR) {
+                _failed = true;
+                break;
+            }
+        }
+        return size - _stream.avail_out;
+    }
+
+    bool failed() const {
+        return _failed;
+    }
+
+private:
+    bool refill() {
+        if (_remaining == 0 && !_input.next(_next, _remaining))
+            return false;
+        std::size_t length = std::min<std::size_t>(_remaining, UINT_MAX);
+        _stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(_next));
+        _stream.avail_in = static_cast<uInt>(length);
+        _next += length;
+        _remaining -= length;
+        return true;
+    }
+
+private:
+    CompressedInput _input;
+    z_stream _stream;
+    const char* _next;
+    std::size_t _remaining;
+    bool _failed;
+    bool _ended;
+    bool _memberEnded;
+};
+
+#endif
+
+#ifdef LXML_HAVE_ZSTD
+
+class ZstdSource : public InputSource {
+public:
+    explicit ZstdSource(CompressedInput&& input)
+    : _input(std::move(input)), _stream(ZSTD_createDStream()), _failed(), _ended(), _frameEnded(true) {
+        _in.src = 0;
+        _in.size = 0;
+        _in.pos = 0;
+        _failed = !_stream || ZSTD_isError(ZSTD_initDStream(_stream));
+    }
+
+    ~ZstdSource() {
+        ZSTD_freeDStream(_stream);
+    }
+
+    std::size_t read(char* buffer, std::size_t size) {
+        if (_failed || _ended)
+            return 0;
+
+        ZSTD_outBuffer out = {buffer, size, 0};
+        while (out.pos < out.size) {
+            if (_in.pos == _in.size) {
+                const char* data;
+                std::size_t length;
+                if (!_input.next(data, length)) {
+                    _failed = !_frameEnded;
+                    _ended = true;
+                    break;
+                }
+                _in.src = data;
+                _in.size = length;
+                _in.pos = 0;
+            }
+
+            std::size_t result = ZSTD_decompressStream(_stream, &out, &_in);
+            if (ZSTD_isError(result)) {
+                _failed = true;
+                break;
+            }
+            _frameEnded = result == 0;
+        }
+        return out.pos;
+    }
+
+    bool failed() const {
+        return _failed;
+    }
+
+private:
+    CompressedInput _input;
+    ZSTD_DStream* _stream;
+    ZSTD_inBuffer _in;
+    bool _failed;
+    bool _ended;
+    bool _frameEnded;
+};
+
+#endif
+
+std::unique_ptr<InputSource> makeSource(Compression compression, CompressedInput&& input) {
+    switch (compression) {
+#ifdef LXML_HAVE_ZLIB
+        case Compression::Gzip:
+            return std::unique_ptr<InputSource>(new GzipSource(std::move(input)));
+#endif
+#ifdef LXML_HAVE_ZSTD
+        case Compression::Zstd:
+            return std::unique_ptr<InputSource>(new ZstdSource(std::move(input)));
+#endif
+        default:
+            return std::unique_ptr<InputSource>();
+    }
+}
+
+} // namespace
+
+std::unique_ptr<InputSource> makeDecompressor(Compression compression, std::istream& is) {
+    return makeSource(compression, CompressedInput(is));
+}
+
+std::unique_ptr<InputSource> makeDecompressor(Compression compression, const char* data, std::size_t length) {
+    return makeSource(compression, CompressedInput(data, length));
+}
+
+} // namespace lxml
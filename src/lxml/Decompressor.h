@@ -0,0 +1,74 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "ReadAhead.h"
+
+#include <cstddef>
+#include <istream>
+#include <memory>
+
+namespace lxml {
+
+/**
+ Compression formats of input documents.
+ */
+enum class Compression {
+    None,
+    Gzip,
+    Zstd
+};
+
+/**
+ Detect the compression of a document from its first bytes.
+ */
+Compression detectCompression(const char* data, std::size_t length);
+
+/**
+ Detect the compression of a stream from its next bytes, without consuming
+ them. The whole magic number is checked when the stream's buffer holds it.
+ Otherwise, as with unbuffered streams or at the very end of the input, the
+ bytes that are there must match and the decompressor checks the rest.
+ */
+Compression detectCompression(std::istream& is);
+
+/**
+ Whether lxml was built with support for a compression format, see
+ `LXML_HAVE_ZLIB` and `LXML_HAVE_ZSTD`.
+ */
+bool isCompressionSupported(Compression compression);
+
+/**
+ Create a source that decompresses a stream.
+ 
+ @return The source, or null if the format is not supported.
+ */
+std::unique_ptr<InputSource> makeDecompressor(Compression compression, std::istream& is);
+
+/**
+ Create a source that decompresses a buffer in memory. The buffer must
+ outlive the source.
+ 
+ @return The source, or null if the format is not supported.
+ */
+std::unique_ptr<InputSource> makeDecompressor(Compression compression, const char* data, std::size_t length);
+
+} // namespace lxml
@@ -19,16 +19,13 @@
 // DEALINGS IN THE SOFTWARE.
 
 #include "DoubleHandler.h"
-#include <cstdlib>
 
 namespace lxml {
 
-void DoubleHandler::endElement(const QName& qname, const std::string& contents) {
-    _result = parseDouble(contents);
-}
-
-double DoubleHandler::parseDouble(const std::string& string) {
-    return strtod(string.c_str(), NULL);
+double DoubleHandler::parseDouble(std::string_view string) {
+    double value = 0;
+    parseNumber(string, value);
+    return value;
 }
 
 } // namespace lxml
@@ -19,7 +19,7 @@
 // DEALINGS IN THE SOFTWARE.
 
 #pragma once
-#include "BaseRecursiveHandler.h"
+#include "NumberHandler.h"
 
 namespace lxml {
 
@@ -27,10 +27,10 @@ namespace lxml {
  DoubleHandler is a recursive handler that parses element contents as
  double values. All sub-elemens are ignored.
  */
-class DoubleHandler : public BaseRecursiveHandler<double> {
+class DoubleHandler : public NumberHandler<double> {
 public:
-    void endElement(const QName& qname, const std::string& contents);
-    static double parseDouble(const std::string& string);
+    /// Parse a double value, `0` if the string is not a valid number
+    static double parseDouble(std::string_view string);
 };
 
 } // namespace lxml
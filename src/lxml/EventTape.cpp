@@ -0,0 +1,643 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "EventTape.h"
+#include "ParseState.h"
+#include "Parser.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace lxml {
+
+static const char kTapeMagic[8] = {'L', 'X', 'M', 'L', 'T', 'A', 'P', 'E'};
+static const std::uint32_t kByteOrderMark = 0x01020304;
+
+// Events not yet written are flushed past this size
+static const std::size_t kFlushSize = 1024*1024;
+
+/**
+ Events are an opcode byte followed by varints and raw bytes:
+ 
+     StartElement  u32 subtree length, name, namespace count,
+                   (prefix, uri) string ids, attribute count,
+                   (name, value length, value bytes) per attribute
+     EndElement
+     Characters    length, bytes
+     EndDocument
+ 
+ String ids are offsets into the strings table plus one, `0` is a null
+ string. The subtree length is the distance from after the length to the
+ element's EndElement, or `0` when it doesn't fit.
+ */
+enum TapeOp : std::uint8_t {
+    EndDocument = 0,
+    StartElement = 1,
+    EndElement = 2,
+    Characters = 3
+};
+
+
+// TapeRecorder
+
+TapeRecorder::TapeRecorder() : _header(), _documentEnded(), _failed(), _flushed() {}
+
+TapeRecorder::~TapeRecorder() {
+    discard();
+}
+
+bool TapeRecorder::open(const std::string& path, std::uint64_t sourceHash, std::uint64_t sourceSize) {
+    discard();
+    
+    _path = path;
+    _temporaryPath = path + ".tmp";
+    _file.open(_temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!_file)
+        return false;
+    
+    _header = TapeHeader();
+    std::memcpy(_header.magic, kTapeMagic, sizeof(kTapeMagic));
+    _header.version = EventTape::kVersion;
+    _header.byteOrder = kByteOrderMark;
+    _header.sourceHash = sourceHash;
+    _header.sourceSize = sourceSize;
+    _header.eventsOffset = sizeof(TapeHeader);
+    
+    // The header is written for real once the tables' offsets are known
+    TapeHeader placeholder = TapeHeader();
+    _file.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+    
+    _documentEnded = false;
+    _failed = false;
+    _buffer.clear();
+    _flushed = 0;
+    _open.clear();
+    _patches.clear();
+    _strings.clear();
+    _stringIds.clear();
+    _names.clear();
+    _nameIds.clear();
+    _nameCache.clear();
+    return true;
+}
+
+bool TapeRecorder::close() {
+    if (!_file.is_open())
+        return false;
+    if (!_documentEnded || _failed || !_open.empty()) {
+        discard();
+        return false;
+    }
+    
+    flush();
+    _header.eventsSize = _flushed;
+    for (const Patch& patch : _patches) {
+        _file.seekp(static_cast<std::streamoff>(_header.eventsOffset + patch.position));
+        _file.write(reinterpret_cast<const char*>(&patch.value), sizeof(patch.value));
+    }
+    _file.seekp(static_cast<std::streamoff>(_header.eventsOffset + _header.eventsSize));
+    
+    _header.stringsOffset = _header.eventsOffset + _header.eventsSize;
+    _header.stringsSize = _strings.size();
+    _file.write(_strings.data(), static_cast<std::streamsize>(_strings.size()));
+    
+    _header.namesOffset = _header.stringsOffset + _header.stringsSize;
+    _header.nameCount = _names.size();
+    _file.write(reinterpret_cast<const char*>(_names.data()), static_cast<std::streamsize>(_names.size() * sizeof(Name)));
+    
+    _file.seekp(0);
+    _file.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    _file.close();
+    if (!_file) {
+        discard();
+        return false;
+    }
+    
+    if (std::rename(_temporaryPath.c_str(), _path.c_str()) != 0) {
+        std::remove(_temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void TapeRecorder::discard() {
+    if (!_file.is_open())
+        return;
+    _file.close();
+    std::remove(_temporaryPath.c_str());
+}
+
+void TapeRecorder::putVarint(std::uint64_t value) {
+    while (value >= 0x80) {
+        putByte(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    putByte(static_cast<std::uint8_t>(value));
+}
+
+void TapeRecorder::putBytes(const char* data, std::size_t length) {
+    putVarint(length);
+    _buffer.append(data, length);
+    if (_buffer.size() >= kFlushSize)
+        flush();
+}
+
+void TapeRecorder::flush() {
+    _file.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+    _flushed += _buffer.size();
+    _buffer.clear();
+}
+
+bool TapeRecorder::sameString(std::uint32_t id, const char* string) const {
+    if (id == 0 || !string)
+        return id == 0 && !string;
+    return std::strcmp(_strings.data() + id - 1, string) == 0;
+}
+
+std::uint32_t TapeRecorder::internString(const char* string) {
+    if (!string)
+        return 0;
+    
+    auto inserted = _stringIds.emplace(string, static_cast<std::uint32_t>(_strings.size() + 1));
+    if (inserted.second)
+        _strings.append(string, std::strlen(string) + 1);
+    return inserted.first->second;
+}
+
+std::uint32_t TapeRecorder::internName(const char* localName, const char* prefix, const char* namespaceURI) {
+    NameKey key = {localName, prefix, namespaceURI};
+    auto it = _nameCache.find(key);
+    if (it != _nameCache.end()) {
+        const Name& name = _names[it->second];
+        if (sameString(name[0], localName) && sameString(name[1], prefix) && sameString(name[2], namespaceURI))
+            return it->second;
+    }
+    
+    Name name = {{internString(localName), internString(prefix), internString(namespaceURI)}};
+    auto inserted = _nameIds.emplace(name, static_cast<std::uint32_t>(_names.size()));
+    if (inserted.second)
+        _names.push_back(name);
+    _nameCache[key] = inserted.first->second;
+    return inserted.first->second;
+}
+
+void TapeRecorder::startDocument() {
+    _documentEnded = false;
+}
+
+void TapeRecorder::endDocument() {
+    putByte(EndDocument);
+    _documentEnded = true;
+}
+
+void TapeRecorder::startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+    putByte(StartElement);
+    _open.push_back(_flushed + _buffer.size());
+    _buffer.append(sizeof(std::uint32_t), '\0');
+    
+    putVarint(internName(qname.localName(), qname.prefix(), qname.namespaceURI()));
+    putVarint(namespaces.size());
+    for (Namespace ns : namespaces) {
+        putVarint(internString(ns.prefix));
+        putVarint(internString(ns.namespaceURI));
+    }
+    putVarint(attributes.size());
+    for (Attribute attribute : attributes) {
+        putVarint(internName(attribute.localName(), attribute.prefix(), attribute.namespaceURI()));
+        std::string_view value = attribute.value();
+        putBytes(value.data(), value.size());
+    }
+}
+
+void TapeRecorder::endElement(const QName& qname) {
+    if (_open.empty()) {
+        _failed = true;
+        return;
+    }
+    
+    std::uint64_t position = _open.back();
+    _open.pop_back();
+    std::uint64_t length = _flushed + _buffer.size() - (position + sizeof(std::uint32_t));
+    if (length <= 0xffffffffu) {
+        std::uint32_t value = static_cast<std::uint32_t>(length);
+        if (position >= _flushed)
+            std::memcpy(&_buffer[position - _flushed], &value, sizeof(value));
+        else
+            _patches.push_back(Patch{position, value});
+    }
+    putByte(EndElement);
+    if (_buffer.size() >= kFlushSize)
+        flush();
+}
+
+void TapeRecorder::characters(const char* chars, std::size_t length) {
+    putByte(Characters);
+    putBytes(chars, length);
+}
+
+void TapeRecorder::error(const xmlError& error) {
+    if (error.level >= XML_ERR_ERROR)
+        _failed = true;
+}
+
+
+// EventTape
+
+/**
+ Reads events with bounds checks, a corrupt tape must not crash.
+ */
+struct EventTape::Cursor {
+    const char* position;
+    const char* end;
+    
+    bool readVarint(std::uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && position < end; shift += 7) {
+            std::uint8_t byte = static_cast<std::uint8_t>(*position++);
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+    
+    bool readBytes(const char*& data, std::uint64_t& length) {
+        if (!readVarint(length) || length > static_cast<std::uint64_t>(end - position))
+            return false;
+        data = position;
+        position += length;
+        return true;
+    }
+};
+
+EventTape::EventTape() : _header(), _events(), _strings(), _state(new ParseState) {
+    _context._state = _state.get();
+}
+
+EventTape::~EventTape() {}
+
+std::uint64_t EventTape::hash(const char* data, std::size_t length) {
+    // xxHash64 with seed 0
+    static const std::uint64_t kPrime1 = 11400714785074694791ull;
+    static const std::uint64_t kPrime2 = 14029467366897019727ull;
+    static const std::uint64_t kPrime3 = 1609587929392839161ull;
+    static const std::uint64_t kPrime4 = 9650029242287828579ull;
+    static const std::uint64_t kPrime5 = 2870177450012600261ull;
+    
+    auto rotate = [](std::uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    };
+    auto read64 = [](const char* p) {
+        std::uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    };
+    auto round = [&](std::uint64_t accumulator, std::uint64_t input) {
+        return rotate(accumulator + input * kPrime2, 31) * kPrime1;
+    };
+    auto merge = [&](std::uint64_t accumulator, std::uint64_t value) {
+        return (accumulator ^ round(0, value)) * kPrime1 + kPrime4;
+    };
+    
+    const char* p = data;
+    const char* end = data + length;
+    std::uint64_t h;
+    if (length >= 32) {
+        std::uint64_t v1 = kPrime1 + kPrime2;
+        std::uint64_t v2 = kPrime2;
+        std::uint64_t v3 = 0;
+        std::uint64_t v4 = 0 - kPrime1;
+        for (; end - p >= 32; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        h = rotate(v1, 1) + rotate(v2, 7) + rotate(v3, 12) + rotate(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    } else {
+        h = kPrime5;
+    }
+    h += length;
+    
+    for (; end - p >= 8; p += 8)
+        h = rotate(h ^ round(0, read64(p)), 27) * kPrime1 + kPrime4;
+    if (end - p >= 4) {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        h = rotate(h ^ (value * kPrime1), 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+        h = rotate(h ^ (static_cast<std::uint8_t>(*p) * kPrime5), 11) * kPrime1;
+    
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+static bool recordTape(const char* data, std::size_t length, std::uint64_t hash, const std::string& tapePath, const ParseOptions& options) {
+    TapeRecorder recorder;
+    if (!recorder.open(tapePath, hash, length))
+        return false;
+    Parser parser(options);
+    if (!parser.parse(data, length, tapePath, recorder))
+        return false;
+    return recorder.close();
+}
+
+bool EventTape::record(const char* data, std::size_t length, const std::string& tapePath, const ParseOptions& options) {
+    return recordTape(data, length, hash(data, length), tapePath, options);
+}
+
+bool EventTape::recordFile(const std::string& xmlPath, const std::string& tapePath, const ParseOptions& options) {
+    MappedFile xml;
+    if (!xml.open(xmlPath))
+        return false;
+    return recordTape(xml.data(), xml.size(), hash(xml.data(), xml.size()), tapePath, options);
+}
+
+bool EventTape::open(const std::string& tapePath) {
+    close();
+    if (!_file.open(tapePath) || _file.size() < sizeof(TapeHeader))
+        return false;
+    
+    std::memcpy(&_header, _file.data(), sizeof(_header));
+    const std::uint64_t size = _file.size();
+    bool valid =
+        std::memcmp(_header.magic, kTapeMagic, sizeof(kTapeMagic)) == 0 &&
+        _header.version == kVersion &&
+        _header.byteOrder == kByteOrderMark &&
+        _header.eventsOffset == sizeof(TapeHeader) &&
+        _header.eventsSize <= size - _header.eventsOffset &&
+        _header.stringsOffset == _header.eventsOffset + _header.eventsSize &&
+        _header.stringsSize <= size - _header.stringsOffset &&
+        _header.namesOffset == _header.stringsOffset + _header.stringsSize &&
+        _header.nameCount <= (size - _header.namesOffset) / (3 * sizeof(std::uint32_t)) &&
+        (_header.stringsSize == 0 || _file.data()[_header.stringsOffset + _header.stringsSize - 1] == '\0');
+    if (!valid) {
+        close();
+        return false;
+    }
+    
+    _events = _file.data() + _header.eventsOffset;
+    _strings = _file.data() + _header.stringsOffset;
+    
+    // Strings are null terminated and the table ends with a terminator, so
+    // any offset in it is a valid string
+    auto string = [&](std::uint32_t id, const char*& result) {
+        if (id > _header.stringsSize)
+            return false;
+        result = id ? _strings + id - 1 : 0;
+        return true;
+    };
+    
+    _names.resize(_header.nameCount);
+    const char* names = _file.data() + _header.namesOffset;
+    for (std::size_t i = 0; i < _names.size(); ++i) {
+        std::uint32_t ids[3];
+        std::memcpy(ids, names + i * sizeof(ids), sizeof(ids));
+        const char* localName;
+        const char* prefix;
+        const char* namespaceURI;
+        if (!string(ids[0], localName) || !localName || !string(ids[1], prefix) || !string(ids[2], namespaceURI)) {
+            close();
+            return false;
+        }
+        _names[i] = QName(localName, prefix, namespaceURI);
+    }
+    return true;
+}
+
+bool EventTape::open(const std::string& tapePath, std::uint64_t sourceHash) {
+    if (!open(tapePath))
+        return false;
+    if (_header.sourceHash != sourceHash) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool EventTape::openCached(const std::string& xmlPath, const std::string& tapePath, const ParseOptions& options) {
+    MappedFile xml;
+    if (!xml.open(xmlPath))
+        return false;
+    
+    std::uint64_t sourceHash = hash(xml.data(), xml.size());
+    if (open(tapePath, sourceHash) && _header.sourceSize == xml.size())
+        return true;
+    
+    close();
+    return recordTape(xml.data(), xml.size(), sourceHash, tapePath, options) && open(tapePath, sourceHash);
+}
+
+void EventTape::close() {
+    _file.close();
+    _header = TapeHeader();
+    _events = 0;
+    _strings = 0;
+    _names.clear();
+}
+
+bool EventTape::replay(SAXHandler& handler) {
+    _state->status = ParseStatus::Ok;
+    _state->skipRequested = false;
+    if (!isOpen())
+        return _state->stop(ParseStatus::Error);
+    
+    ParseContext::Scope scope(_context);
+    return replayEvents(handler);
+}
+
+bool EventTape::replay(RecursiveHandler& handler) {
+    _rootHandler.reset(&handler);
+    return replay(static_cast<SAXHandler&>(_rootHandler));
+}
+
+ParseStatus EventTape::status() const {
+    return _state->status;
+}
+
+bool EventTape::replayEvents(SAXHandler& handler) {
+    Cursor cursor = {_events, _events + _header.eventsSize};
+    _openNames.clear();
+    handler.startDocument();
+    
+    while (cursor.position < cursor.end) {
+        switch (static_cast<std::uint8_t>(*cursor.position++)) {
+            case StartElement: {
+                std::uint32_t subtree;
+                if (cursor.end - cursor.position < static_cast<std::ptrdiff_t>(sizeof(subtree)))
+                    return _state->stop(ParseStatus::Error);
+                std::memcpy(&subtree, cursor.position, sizeof(subtree));
+                cursor.position += sizeof(subtree);
+                const char* subtreeEnd = subtree ? cursor.position + subtree : 0;
+                
+                std::uint64_t name, namespaceCount, attributeCount;
+                if (!cursor.readVarint(name) || name >= _names.size() || !cursor.readVarint(namespaceCount) ||
+                    namespaceCount > static_cast<std::uint64_t>(cursor.end - cursor.position))
+                    return _state->stop(ParseStatus::Error);
+                
+                _namespaceArray.resize(namespaceCount * 2);
+                for (std::size_t i = 0; i < _namespaceArray.size(); ++i) {
+                    std::uint64_t id;
+                    if (!cursor.readVarint(id) || id > _header.stringsSize)
+                        return _state->stop(ParseStatus::Error);
+                    _namespaceArray[i] = id ? reinterpret_cast<const xmlChar*>(_strings + id - 1) : 0;
+                }
+                
+                if (!cursor.readVarint(attributeCount) || attributeCount > static_cast<std::uint64_t>(cursor.end - cursor.position))
+                    return _state->stop(ParseStatus::Error);
+                _attributeArray.resize(attributeCount * 5);
+                for (std::size_t i = 0; i < _attributeArray.size(); i += 5) {
+                    std::uint64_t attributeName, length;
+                    const char* value;
+                    if (!cursor.readVarint(attributeName) || attributeName >= _names.size() || !cursor.readBytes(value, length))
+                        return _state->stop(ParseStatus::Error);
+                    const QName& qname = _names[attributeName];
+                    _attributeArray[i] = reinterpret_cast<const xmlChar*>(qname.localName());
+                    _attributeArray[i + 1] = reinterpret_cast<const xmlChar*>(qname.prefix());
+                    _attributeArray[i + 2] = reinterpret_cast<const xmlChar*>(qname.namespaceURI());
+                    _attributeArray[i + 3] = reinterpret_cast<const xmlChar*>(value);
+                    _attributeArray[i + 4] = reinterpret_cast<const xmlChar*>(value + length);
+                }
+                
+                // Like a parse, only honor skips asked for by this element
+                _openNames.push_back(static_cast<std::uint32_t>(name));
+                _state->skipRequested = false;
+                handler.startElement(_names[name],
+                                     NamespaceView(_namespaceArray.data(), static_cast<int>(namespaceCount)),
+                                     AttributeView(_attributeArray.data(), static_cast<int>(attributeCount)));
+                if (_state->status != ParseStatus::Ok)
+                    return false;
+                if (_state->skipRequested) {
+                    _state->skipRequested = false;
+                    if (!skip(cursor, subtreeEnd))
+                        return _state->stop(ParseStatus::Error);
+                }
+                break;
+            }
+                
+            case EndElement:
+                if (_openNames.empty())
+                    return _state->stop(ParseStatus::Error);
+                handler.endElement(_names[_openNames.back()]);
+                _openNames.pop_back();
+                break;
+                
+            case Characters: {
+                const char* chars;
+                std::uint64_t length;
+                if (!cursor.readBytes(chars, length))
+                    return _state->stop(ParseStatus::Error);
+                handler.characters(chars, static_cast<std::size_t>(length));
+                break;
+            }
+                
+            case EndDocument:
+                if (!_openNames.empty())
+                    return _state->stop(ParseStatus::Error);
+                handler.endDocument();
+                return _state->status == ParseStatus::Ok;
+                
+            default:
+                return _state->stop(ParseStatus::Error);
+        }
+        
+        if (_state->status != ParseStatus::Ok)
+            return false;
+    }
+    
+    // The events ended without EndDocument
+    return _state->stop(ParseStatus::Error);
+}
+
+bool EventTape::skip(Cursor& cursor, const char* subtreeEnd) {
+    // Jump straight to the element's end when the recorder knew its length
+    if (subtreeEnd) {
+        if (subtreeEnd < cursor.position || subtreeEnd >= cursor.end || *subtreeEnd != EndElement)
+            return false;
+        cursor.position = subtreeEnd;
+        return true;
+    }
+    
+    // Otherwise decode events until the element's end
+    std::size_t depth = 0;
+    while (cursor.position < cursor.end) {
+        const char* event = cursor.position++;
+        std::uint64_t value;
+        const char* data;
+        switch (static_cast<std::uint8_t>(*event)) {
+            case StartElement: {
+                std::uint32_t subtree;
+                if (cursor.end - cursor.position < static_cast<std::ptrdiff_t>(sizeof(subtree)))
+                    return false;
+                std::memcpy(&subtree, cursor.position, sizeof(subtree));
+                cursor.position += sizeof(subtree);
+                if (subtree) {
+                    // A nested element of known length
+                    if (subtree >= static_cast<std::uint64_t>(cursor.end - cursor.position))
+                        return false;
+                    cursor.position += subtree + 1;
+                    break;
+                }
+                std::uint64_t count;
+                if (!cursor.readVarint(value) || !cursor.readVarint(count))
+                    return false;
+                for (std::uint64_t i = 0; i < count * 2; ++i) {
+                    if (!cursor.readVarint(value))
+                        return false;
+                }
+                if (!cursor.readVarint(count))
+                    return false;
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    if (!cursor.readVarint(value) || !cursor.readBytes(data, value))
+                        return false;
+                }
+                ++depth;
+                break;
+            }
+            case EndElement:
+                if (depth == 0) {
+                    cursor.position = event;
+                    return true;
+                }
+                --depth;
+                break;
+            case Characters:
+                if (!cursor.readBytes(data, value))
+                    return false;
+                break;
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+} // namespace lxml
@@ -0,0 +1,290 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "MappedFile.h"
+#include "ParseContext.h"
+#include "ParseOptions.h"
+#include "ParseStatus.h"
+#include "RootRecursiveHandler.h"
+#include "SAXHandler.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lxml {
+
+struct ParseState;
+
+/**
+ The fixed header at the start of a tape file. Offsets are from the start
+ of the file, integers are in the byte order of the machine that wrote the
+ tape.
+ */
+struct TapeHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    
+    /// EventTape::hash of the XML the tape was recorded from, and its size
+    std::uint64_t sourceHash;
+    std::uint64_t sourceSize;
+    
+    std::uint64_t eventsOffset;
+    std::uint64_t eventsSize;
+    
+    /// Null terminated strings, referred to by offset
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+    
+    /// Local name, prefix and namespace URI string ids of each name
+    std::uint64_t namesOffset;
+    std::uint64_t nameCount;
+};
+
+/**
+ TapeRecorder is a SAXHandler that writes the events of a document to a
+ tape file that EventTape replays.
+ 
+ Events are written as they arrive. Element and attribute names are
+ interned and refer to tables written after the events, text and attribute
+ values are stored inline. The tape is written to a temporary file that
+ only replaces `path` when the whole document was recorded, so a tape
+ file is either complete or absent.
+ */
+class TapeRecorder : public SAXHandler {
+public:
+    TapeRecorder();
+    
+    /// Discards an unfinished tape
+    ~TapeRecorder();
+    
+    TapeRecorder(const TapeRecorder&) = delete;
+    TapeRecorder& operator=(const TapeRecorder&) = delete;
+    
+    /**
+     Start a tape.
+     
+     @param path       The tape file to write.
+     @param sourceHash EventTape::hash of the XML about to be recorded.
+     @param sourceSize The size of the XML.
+     */
+    bool open(const std::string& path, std::uint64_t sourceHash, std::uint64_t sourceSize);
+    
+    /**
+     Write the name tables and move the tape into place.
+     
+     @return `false` if the document wasn't completely recorded without
+             errors, or the tape couldn't be written. Nothing is left at
+             `path` then.
+     */
+    bool close();
+    
+    virtual void startDocument();
+    virtual void endDocument();
+    
+    virtual void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes);
+    virtual void endElement(const QName& qname);
+    
+    virtual void characters(const char* chars, std::size_t length);
+    virtual void error(const xmlError& error);
+    
+private:
+    /// The parser's name strings, interned for the duration of a document
+    struct NameKey {
+        const char* localName;
+        const char* prefix;
+        const char* namespaceURI;
+        
+        bool operator==(const NameKey& key) const {
+            return localName == key.localName && prefix == key.prefix && namespaceURI == key.namespaceURI;
+        }
+    };
+    
+    struct NameKeyHash {
+        std::size_t operator()(const NameKey& key) const {
+            std::uintptr_t hash = reinterpret_cast<std::uintptr_t>(key.localName) * 0x9E3779B97F4A7C15ull;
+            hash ^= reinterpret_cast<std::uintptr_t>(key.prefix) * 0xC2B2AE3D27D4EB4Full;
+            hash ^= reinterpret_cast<std::uintptr_t>(key.namespaceURI) * 0x165667B19E3779F9ull;
+            return static_cast<std::size_t>(hash ^ (hash >> 29));
+        }
+    };
+    
+    typedef std::array<std::uint32_t, 3> Name;
+    
+    /// A subtree length to fill in once it is known
+    struct Patch {
+        std::uint64_t position;
+        std::uint32_t value;
+    };
+    
+    std::uint32_t internString(const char* string);
+    bool sameString(std::uint32_t id, const char* string) const;
+    std::uint32_t internName(const char* localName, const char* prefix, const char* namespaceURI);
+    
+    void putByte(std::uint8_t byte) {
+        _buffer.push_back(static_cast<char>(byte));
+    }
+    void putVarint(std::uint64_t value);
+    void putBytes(const char* data, std::size_t length);
+    void flush();
+    void discard();
+    
+private:
+    std::ofstream _file;
+    std::string _path;
+    std::string _temporaryPath;
+    TapeHeader _header;
+    bool _documentEnded;
+    bool _failed;
+    
+    /// Events not yet written and the number of bytes written before them
+    std::string _buffer;
+    std::uint64_t _flushed;
+    
+    /// Positions of the subtree lengths of open elements
+    std::vector<std::uint64_t> _open;
+    std::vector<Patch> _patches;
+    
+    std::string _strings;
+    std::unordered_map<std::string, std::uint32_t> _stringIds;
+    std::vector<Name> _names;
+    std::map<Name, std::uint32_t> _nameIds;
+    std::unordered_map<NameKey, std::uint32_t, NameKeyHash> _nameCache;
+};
+
+/**
+ EventTape replays a tape written by TapeRecorder into any SAXHandler or
+ RecursiveHandler, as if the original XML was being parsed, without
+ parsing it again.
+ 
+ The tape is memory mapped and replayed in place: names, attribute values
+ and text are delivered as pointers into the mapping. Handlers can call
+ `ParseContext::current()->skipSubtree()`, which jumps over the subtree
+ without decoding it, and `stop()`.
+ 
+ Tapes record EventTape::hash of their source so that a cached tape can be
+ checked against the current XML, `openCached` does both.
+ */
+class EventTape {
+public:
+    static constexpr std::uint32_t kVersion = 1;
+    
+public:
+    EventTape();
+    ~EventTape();
+    
+    EventTape(const EventTape&) = delete;
+    EventTape& operator=(const EventTape&) = delete;
+    
+    /**
+     A 64-bit hash of XML content for keying tapes. It is not
+     cryptographic, it detects changed inputs.
+     */
+    static std::uint64_t hash(const char* data, std::size_t length);
+    
+    /**
+     Parse XML and record its tape.
+     */
+    static bool record(const char* data, std::size_t length, const std::string& tapePath, const ParseOptions& options = ParseOptions());
+    static bool recordFile(const std::string& xmlPath, const std::string& tapePath, const ParseOptions& options = ParseOptions());
+    
+    /**
+     Map a tape and check its structure.
+     
+     @return `false` if the file is missing, isn't a tape of this version
+             and byte order, or is truncated.
+     */
+    bool open(const std::string& tapePath);
+    
+    /**
+     Map a tape if it was recorded from XML with the given hash.
+     */
+    bool open(const std::string& tapePath, std::uint64_t sourceHash);
+    
+    /**
+     Map the tape of an XML file, recording it first if the tape is missing
+     or was recorded from different content.
+     */
+    bool openCached(const std::string& xmlPath, const std::string& tapePath, const ParseOptions& options = ParseOptions());
+    
+    void close();
+    
+    bool isOpen() const {
+        return _file.isOpen();
+    }
+    
+    std::uint64_t sourceHash() const {
+        return _header.sourceHash;
+    }
+    
+    std::uint64_t sourceSize() const {
+        return _header.sourceSize;
+    }
+    
+    /**
+     Deliver the tape's events to a handler.
+     
+     @return `true` if every event was delivered, `false` if the handler
+             stopped the replay or the tape is corrupt, see `status()`.
+     */
+    bool replay(SAXHandler& handler);
+    bool replay(RecursiveHandler& handler);
+    
+    /**
+     How the last replay ended: `Ok`, `Stopped` by the handler, or `Error`
+     for a corrupt tape.
+     */
+    ParseStatus status() const;
+    
+private:
+    struct Cursor;
+    
+    bool replayEvents(SAXHandler& handler);
+    bool skip(Cursor& cursor, const char* subtreeEnd);
+    
+private:
+    MappedFile _file;
+    TapeHeader _header;
+    const char* _events;
+    const char* _strings;
+    
+    /// Names pointing into the mapping
+    std::vector<QName> _names;
+    
+    /// libxml2 style arrays for the views of the element being replayed
+    std::vector<const xmlChar*> _namespaceArray;
+    std::vector<const xmlChar*> _attributeArray;
+    std::vector<std::uint32_t> _openNames;
+    
+    std::unique_ptr<ParseState> _state;
+    ParseContext _context;
+    RootRecursiveHandler _rootHandler;
+};
+
+} // namespace lxml
@@ -0,0 +1,252 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "FlatDocument.h"
+#include "ParseContext.h"
+#include "Whitespace.h"
+
+#include <cstring>
+
+namespace lxml {
+
+FlatDocument::FlatDocument() {}
+
+void FlatDocument::clear() {
+    _parents.clear();
+    _firstChildren.clear();
+    _nextSiblings.clear();
+    _names.clear();
+    _textOffsets.clear();
+    _textLengths.clear();
+    _attributeBegins.clear();
+    _attributes.clear();
+    _strings.clear();
+    _nameStrings.clear();
+    _nameIds.clear();
+}
+
+FlatDocument::NodeId FlatDocument::subtreeEnd(NodeId node) const {
+    for (; node != npos; node = _parents[node]) {
+        if (_nextSiblings[node] != npos)
+            return _nextSiblings[node];
+    }
+    return static_cast<NodeId>(size());
+}
+
+FlatDocument::NodeId FlatDocument::child(NodeId node, NameId name) const {
+    NodeId child = _firstChildren[node];
+    if (child != npos && _names[child] != name)
+        child = nextSibling(child, name);
+    return child;
+}
+
+FlatDocument::NodeId FlatDocument::nextSibling(NodeId node, NameId name) const {
+    if (name == npos)
+        return npos;
+    for (node = _nextSiblings[node]; node != npos; node = _nextSiblings[node]) {
+        if (_names[node] == name)
+            return node;
+    }
+    return npos;
+}
+
+std::string FlatDocument::nameKey(std::string_view localName, std::string_view namespaceURI) {
+    // Clark notation, `}` can't appear in a namespace URI
+    std::string key;
+    if (!namespaceURI.empty()) {
+        key.reserve(namespaceURI.size() + localName.size() + 2);
+        key += '{';
+        key += namespaceURI;
+        key += '}';
+    }
+    key += localName;
+    return key;
+}
+
+FlatDocument::NameId FlatDocument::findName(std::string_view localName, std::string_view namespaceURI) const {
+    auto it = _nameIds.find(nameKey(localName, namespaceURI));
+    return it == _nameIds.end() ? npos : it->second;
+}
+
+FlatDocument::NameId FlatDocument::addName(std::string_view localName, std::string_view namespaceURI) {
+    auto inserted = _nameIds.emplace(nameKey(localName, namespaceURI), static_cast<NameId>(_nameStrings.size()));
+    if (inserted.second)
+        _nameStrings.emplace_back(std::string(localName), std::string(namespaceURI));
+    return inserted.first->second;
+}
+
+std::uint32_t FlatDocument::addString(std::string_view string) {
+    if (string.size() > kMaxStringBytes - _strings.size())
+        return npos;
+    std::uint32_t offset = static_cast<std::uint32_t>(_strings.size());
+    _strings.append(string.data(), string.size());
+    return offset;
+}
+
+std::string_view FlatDocument::attribute(NodeId node, NameId name, std::string_view defaultValue) const {
+    if (name == npos)
+        return defaultValue;
+    for (std::size_t i = _attributeBegins[node], end = attributeEnd(node); i < end; ++i) {
+        if (_attributes[i].name == name)
+            return std::string_view(_strings.data() + _attributes[i].valueOffset, _attributes[i].valueLength);
+    }
+    return defaultValue;
+}
+
+std::size_t FlatDocument::memoryUsage() const {
+    std::size_t bytes =
+        _parents.capacity() * sizeof(NodeId) +
+        _firstChildren.capacity() * sizeof(NodeId) +
+        _nextSiblings.capacity() * sizeof(NodeId) +
+        _names.capacity() * sizeof(NameId) +
+        _textOffsets.capacity() * sizeof(std::uint32_t) +
+        _textLengths.capacity() * sizeof(std::uint32_t) +
+        _attributeBegins.capacity() * sizeof(std::uint32_t) +
+        _attributes.capacity() * sizeof(Attribute) +
+        _strings.capacity();
+    for (const auto& name : _nameStrings)
+        bytes += name.first.capacity() + name.second.capacity();
+    return bytes;
+}
+
+void FlatDocument::shrinkToFit() {
+    _parents.shrink_to_fit();
+    _firstChildren.shrink_to_fit();
+    _nextSiblings.shrink_to_fit();
+    _names.shrink_to_fit();
+    _textOffsets.shrink_to_fit();
+    _textLengths.shrink_to_fit();
+    _attributeBegins.shrink_to_fit();
+    _attributes.shrink_to_fit();
+    _strings.shrink_to_fit();
+}
+
+
+FlatDocumentBuilder::FlatDocumentBuilder(bool keepWhitespace) : _keepWhitespace(keepWhitespace), _depth() {}
+
+void FlatDocumentBuilder::startDocument() {
+    _document.clear();
+    _depth = 0;
+    _nameCache.clear();
+}
+
+void FlatDocumentBuilder::endDocument() {
+    _document.shrinkToFit();
+}
+
+FlatDocument::NameId FlatDocumentBuilder::nameId(const QName& qname) {
+    const char* localName = qname.localName();
+    const char* namespaceURI = qname.namespaceURI() ? qname.namespaceURI() : "";
+    
+    NameKey key = {localName, namespaceURI};
+    auto it = _nameCache.find(key);
+    if (it != _nameCache.end() &&
+        _document.nameLocalName(it->second) == localName &&
+        _document.nameNamespaceURI(it->second) == namespaceURI)
+        return it->second;
+    
+    FlatDocument::NameId id = _document.addName(localName, namespaceURI);
+    _nameCache[key] = id;
+    return id;
+}
+
+void FlatDocumentBuilder::startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+    FlatDocument& d = _document;
+    if (d.size() >= FlatDocument::kMaxNodes || d._attributes.size() + attributes.size() > FlatDocument::kMaxNodes) {
+        if (ParseContext* context = ParseContext::current())
+            context->stop();
+        return;
+    }
+    
+    FlatDocument::NodeId node = static_cast<FlatDocument::NodeId>(d.size());
+    FlatDocument::NodeId parent = FlatDocument::npos;
+    if (_depth > 0) {
+        Level& level = _levels[_depth - 1];
+        parent = level.node;
+        if (level.lastChild == FlatDocument::npos)
+            d._firstChildren[parent] = node;
+        else
+            d._nextSiblings[level.lastChild] = node;
+        level.lastChild = node;
+    }
+    
+    d._parents.push_back(parent);
+    d._firstChildren.push_back(FlatDocument::npos);
+    d._nextSiblings.push_back(FlatDocument::npos);
+    d._names.push_back(nameId(qname));
+    d._textOffsets.push_back(0);
+    d._textLengths.push_back(0);
+    d._attributeBegins.push_back(static_cast<std::uint32_t>(d._attributes.size()));
+    
+    for (Attribute attribute : attributes) {
+        std::string_view value = attribute.value();
+        FlatDocument::Attribute flat;
+        flat.name = nameId(attribute.qname());
+        flat.valueOffset = d.addString(value);
+        flat.valueLength = static_cast<std::uint32_t>(value.size());
+        if (flat.valueOffset == FlatDocument::npos) {
+            if (ParseContext* context = ParseContext::current())
+                context->stop();
+            break;
+        }
+        d._attributes.push_back(flat);
+    }
+    
+    if (_depth == _levels.size())
+        _levels.emplace_back();
+    Level& level = _levels[_depth++];
+    level.node = node;
+    level.lastChild = FlatDocument::npos;
+    level.text.clear();
+}
+
+void FlatDocumentBuilder::endElement(const QName& qname) {
+    // The parse was stopped in the middle of an element
+    if (_depth == 0)
+        return;
+    
+    FlatDocument& d = _document;
+    Level& level = _levels[--_depth];
+    std::string_view text = level.text;
+    if (!_keepWhitespace && level.lastChild != FlatDocument::npos && trim(text).empty())
+        text = std::string_view();
+    if (!text.empty()) {
+        std::uint32_t offset = d.addString(text);
+        if (offset == FlatDocument::npos) {
+            if (ParseContext* context = ParseContext::current())
+                context->stop();
+            return;
+        }
+        d._textOffsets[level.node] = offset;
+        d._textLengths[level.node] = static_cast<std::uint32_t>(text.size());
+    }
+}
+
+void FlatDocumentBuilder::characters(const char* chars, std::size_t length) {
+    if (_depth > 0)
+        _levels[_depth - 1].text.append(chars, length);
+}
+
+void FlatDocumentBuilder::error(const xmlError& error) {
+    
+}
+
+} // namespace lxml
@@ -0,0 +1,296 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "SAXHandler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lxml {
+
+/**
+ FlatDocument is a compact, read-only element tree. Instead of a node object
+ per element, each property of the elements is an array indexed by NodeId:
+ parent, first child and next sibling links, an interned name and the
+ element's text as a range of one string arena. Attributes are kept in a
+ side table, their values in the same arena. An element costs 28 bytes plus
+ its text and attributes, with no per-element allocations.
+ 
+ Node ids are assigned in document order, so iterating from `0` to `size()`
+ is a preorder traversal and the subtree of a node is the range
+ `[node, subtreeEnd(node))`.
+ 
+ A FlatDocument is built by parsing with a FlatDocumentBuilder.
+ */
+class FlatDocument {
+public:
+    typedef std::uint32_t NodeId;
+    typedef std::uint32_t NameId;
+    
+    static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+    
+    /// The largest number of elements or attributes a document can hold
+    static constexpr std::size_t kMaxNodes = npos - 1;
+    
+    /// The most text and attribute values a document can hold, in bytes
+    static constexpr std::size_t kMaxStringBytes = npos - 1;
+    
+public:
+    FlatDocument();
+    
+    void clear();
+    
+    bool empty() const {
+        return _names.empty();
+    }
+    
+    /**
+     The number of elements.
+     */
+    std::size_t size() const {
+        return _names.size();
+    }
+    
+    /**
+     The document element, `npos` if the document is empty.
+     */
+    NodeId root() const {
+        return empty() ? npos : 0;
+    }
+    
+    NodeId parent(NodeId node) const {
+        return _parents[node];
+    }
+    
+    NodeId firstChild(NodeId node) const {
+        return _firstChildren[node];
+    }
+    
+    NodeId nextSibling(NodeId node) const {
+        return _nextSiblings[node];
+    }
+    
+    /**
+     The node after the last descendant of `node`, which is `size()` for the
+     last subtree of the document.
+     */
+    NodeId subtreeEnd(NodeId node) const;
+    
+    /**
+     The first child of `node` with the given name, or `npos`.
+     */
+    NodeId child(NodeId node, NameId name) const;
+    NodeId child(NodeId node, std::string_view localName, std::string_view namespaceURI = std::string_view()) const {
+        return child(node, findName(localName, namespaceURI));
+    }
+    
+    /**
+     The next sibling of `node` with the given name, or `npos`. Together with
+     `child` this iterates over the children with a name.
+     */
+    NodeId nextSibling(NodeId node, NameId name) const;
+    
+    NameId name(NodeId node) const {
+        return _names[node];
+    }
+    
+    std::string_view localName(NodeId node) const {
+        return nameLocalName(_names[node]);
+    }
+    
+    /**
+     The text directly inside an element, without that of its children.
+     */
+    std::string_view text(NodeId node) const {
+        return std::string_view(_strings.data() + _textOffsets[node], _textLengths[node]);
+    }
+    
+    /**
+     The number of distinct element and attribute names.
+     */
+    std::size_t nameCount() const {
+        return _nameStrings.size();
+    }
+    
+    std::string_view nameLocalName(NameId name) const {
+        return _nameStrings[name].first;
+    }
+    
+    std::string_view nameNamespaceURI(NameId name) const {
+        return _nameStrings[name].second;
+    }
+    
+    /**
+     The id of a name, `npos` if no element or attribute in the document has
+     it. Looking a name up once and comparing ids is faster than comparing
+     strings.
+     */
+    NameId findName(std::string_view localName, std::string_view namespaceURI = std::string_view()) const;
+    
+    std::size_t attributeCount(NodeId node) const {
+        return attributeEnd(node) - _attributeBegins[node];
+    }
+    
+    NameId attributeName(NodeId node, std::size_t index) const {
+        return _attributes[_attributeBegins[node] + index].name;
+    }
+    
+    std::string_view attributeValue(NodeId node, std::size_t index) const {
+        const Attribute& attribute = _attributes[_attributeBegins[node] + index];
+        return std::string_view(_strings.data() + attribute.valueOffset, attribute.valueLength);
+    }
+    
+    /**
+     The value of an attribute of `node`, `defaultValue` if it has none with
+     that name.
+     */
+    std::string_view attribute(NodeId node, NameId name, std::string_view defaultValue = std::string_view()) const;
+    std::string_view attribute(NodeId node, std::string_view localName, std::string_view defaultValue = std::string_view()) const {
+        return attribute(node, findName(localName), defaultValue);
+    }
+    
+    /**
+     The bytes held by the document's arrays, including spare capacity.
+     */
+    std::size_t memoryUsage() const;
+    
+    /**
+     Release spare capacity left over from building.
+     */
+    void shrinkToFit();
+    
+private:
+    friend class FlatDocumentBuilder;
+    
+    struct Attribute {
+        NameId name;
+        std::uint32_t valueOffset;
+        std::uint32_t valueLength;
+    };
+    
+    std::size_t attributeEnd(NodeId node) const {
+        return node + 1 < _attributeBegins.size() ? _attributeBegins[node + 1] : _attributes.size();
+    }
+    
+    static std::string nameKey(std::string_view localName, std::string_view namespaceURI);
+    NameId addName(std::string_view localName, std::string_view namespaceURI);
+    
+    /**
+     Append to the string arena.
+     
+     @return The offset of the string, `npos` if the arena is full.
+     */
+    std::uint32_t addString(std::string_view string);
+    
+private:
+    std::vector<NodeId> _parents;
+    std::vector<NodeId> _firstChildren;
+    std::vector<NodeId> _nextSiblings;
+    std::vector<NameId> _names;
+    std::vector<std::uint32_t> _textOffsets;
+    std::vector<std::uint32_t> _textLengths;
+    std::vector<std::uint32_t> _attributeBegins;
+    
+    std::vector<Attribute> _attributes;
+    std::string _strings;
+    
+    /// Local name and namespace URI of each name id
+    std::vector<std::pair<std::string, std::string>> _nameStrings;
+    std::unordered_map<std::string, NameId> _nameIds;
+};
+
+/**
+ FlatDocumentBuilder is a SAXHandler that builds a FlatDocument.
+ 
+ Text that is only whitespace is dropped from elements that have child
+ elements, since it is usually indentation, unless `keepWhitespace` is
+ set. The parse stops if the document has more elements, attributes or
+ text than a FlatDocument can hold.
+ */
+class FlatDocumentBuilder : public SAXHandler {
+public:
+    explicit FlatDocumentBuilder(bool keepWhitespace = false);
+    
+    FlatDocument& document() {
+        return _document;
+    }
+    const FlatDocument& document() const {
+        return _document;
+    }
+    
+    virtual void startDocument();
+    virtual void endDocument();
+    
+    virtual void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes);
+    virtual void endElement(const QName& qname);
+    
+    virtual void characters(const char* chars, std::size_t length);
+    virtual void error(const xmlError& error);
+    
+private:
+    /// An open element
+    struct Level {
+        FlatDocument::NodeId node;
+        FlatDocument::NodeId lastChild;
+        
+        /// Text collected until the element ends, so that the text of
+        /// children doesn't split it
+        std::string text;
+    };
+    
+    struct NameKey {
+        const char* localName;
+        const char* namespaceURI;
+        
+        bool operator==(const NameKey& key) const {
+            return localName == key.localName && namespaceURI == key.namespaceURI;
+        }
+    };
+    
+    struct NameKeyHash {
+        std::size_t operator()(const NameKey& key) const {
+            return std::hash<const void*>()(key.localName) * 31 + std::hash<const void*>()(key.namespaceURI);
+        }
+    };
+    
+    FlatDocument::NameId nameId(const QName& qname);
+    
+private:
+    FlatDocument _document;
+    bool _keepWhitespace;
+    
+    /// Open elements, levels past `_depth` are kept for their buffers
+    std::vector<Level> _levels;
+    std::size_t _depth;
+    
+    /// Name ids by the parser's string pointers, which libxml2 interns in
+    /// its dictionary. Hits are checked against the strings, so a reused
+    /// pointer can't produce the wrong name.
+    std::unordered_map<NameKey, FlatDocument::NameId, NameKeyHash> _nameCache;
+};
+
+} // namespace lxml
@@ -19,16 +19,13 @@
 // DEALINGS IN THE SOFTWARE.
 
 #include "IntegerHandler.h"
-#include <cstdlib>
 
 namespace lxml {
 
-void IntegerHandler::endElement(const QName& qname, const std::string& contents) {
-    _result = parseInteger(contents);
-}
-
-int IntegerHandler::parseInteger(const std::string& string) {
-    return (int)strtol(string.c_str(), NULL, 10);
+int IntegerHandler::parseInteger(std::string_view string) {
+    int value = 0;
+    parseNumber(string, value);
+    return value;
 }
 
 } // namespace lxml
@@ -19,7 +19,7 @@
 // DEALINGS IN THE SOFTWARE.
 
 #pragma once
-#include "BaseRecursiveHandler.h"
+#include "NumberHandler.h"
 
 namespace lxml {
 
@@ -27,10 +27,10 @@ namespace lxml {
  IntegerHandler is a recursive handler that parses element contents as
  integer values. All sub-elemens are ignored.
  */
-class IntegerHandler : public BaseRecursiveHandler<int> {
+class IntegerHandler : public NumberHandler<int> {
 public:
-    void endElement(const QName& qname, const std::string& contents);
-    static int parseInteger(const std::string& string);
+    /// Parse an integer value, `0` if the string is not a valid number
+    static int parseInteger(std::string_view string);
 };
 
 } // namespace lxml
@@ -33,7 +33,11 @@ class ListHandler : public BaseRecursiveHandler<std::vector<T>> {
 public:
     ListHandler(BaseRecursiveHandler<T>& itemHandler) : _itemHandler(itemHandler) {}
     
-    void startElement(const QName& qname, const RecursiveHandler::AttributeMap& attributes) {
+    ContentPolicy contentPolicy() const {
+        return ContentPolicy::Ignore;
+    }
+    
+    void startElement(const QName& qname, const AttributeView& attributes) {
         this->_result.clear();
     }
     
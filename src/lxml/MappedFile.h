@@ -0,0 +1,78 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace lxml {
+
+/**
+ MappedFile is a read-only memory mapping of a file. The mapping is advised
+ for sequential access so that the kernel reads ahead aggressively and can
+ drop pages after they have been consumed.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     Map a file into memory, unmapping any previously mapped file.
+
+     @param path The path of the file to map.
+
+     @return `true` if the file was mapped, `false` if it could not be
+             opened or mapped.
+     */
+    bool open(const std::string& path);
+
+    /**
+     Unmap the file. This is called automatically on destruction.
+     */
+    void close();
+
+    bool isOpen() const {
+        return _open;
+    }
+
+    /**
+     The mapped contents of the file. This is `0` for empty files.
+     */
+    const char* data() const {
+        return _data;
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+
+private:
+    const char* _data;
+    std::size_t _size;
+    bool _open;
+};
+
+} // namespace lxml
@@ -0,0 +1,129 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "QName.h"
+
+#include <libxml/parser.h>
+#include <map>
+
+namespace lxml {
+
+/**
+ Namespace is a namespace declaration, a prefix bound to a namespace URI.
+ The prefix is `0` for the default namespace.
+ */
+struct Namespace {
+    const char* prefix;
+    const char* namespaceURI;
+};
+
+/**
+ NamespaceView is a non-owning range over the namespace declarations of an
+ element as reported by libxml2. Constructing, iterating and querying a
+ view never allocates. Views are only valid for the duration of the
+ callback they were delivered to; use `toMap` to keep a copy.
+ */
+class NamespaceView {
+public:
+    typedef std::map<const char*, const char*> Map;
+
+    class Iterator {
+    public:
+        explicit Iterator(const xmlChar** ns) : _namespace(ns) {}
+
+        Namespace operator*() const {
+            Namespace ns = {
+                reinterpret_cast<const char*>(_namespace[0]),
+                reinterpret_cast<const char*>(_namespace[1])
+            };
+            return ns;
+        }
+        Iterator& operator++() {
+            _namespace += kNamespaceStride;
+            return *this;
+        }
+        bool operator==(const Iterator& it) const {
+            return _namespace == it._namespace;
+        }
+        bool operator!=(const Iterator& it) const {
+            return _namespace != it._namespace;
+        }
+
+    private:
+        const xmlChar** _namespace;
+    };
+
+public:
+    NamespaceView() : _namespaces(), _count() {}
+    NamespaceView(const xmlChar** namespaces, int count) : _namespaces(namespaces), _count(static_cast<std::size_t>(count)) {}
+
+    std::size_t size() const {
+        return _count;
+    }
+    bool empty() const {
+        return _count == 0;
+    }
+
+    Namespace operator[](std::size_t index) const {
+        return *Iterator(_namespaces + index * kNamespaceStride);
+    }
+    Iterator begin() const {
+        return Iterator(_namespaces);
+    }
+    Iterator end() const {
+        return Iterator(_namespaces + _count * kNamespaceStride);
+    }
+
+    /**
+     Find the namespace URI bound to a prefix in this element.
+
+     @param prefix The prefix to look up, `0` for the default namespace.
+
+     @return The namespace URI or `0` if this element does not declare the
+             prefix.
+     */
+    const char* find(const char* prefix) const {
+        for (Namespace ns : *this) {
+            if (QName::compare(ns.prefix, prefix) == 0)
+                return ns.namespaceURI;
+        }
+        return 0;
+    }
+
+    /**
+     Copy the namespace declarations into a map.
+     */
+    Map toMap() const {
+        Map map;
+        for (Namespace ns : *this)
+            map.insert(std::make_pair(ns.prefix, ns.namespaceURI));
+        return map;
+    }
+
+private:
+    static const std::size_t kNamespaceStride = 2;
+
+    const xmlChar** _namespaces;
+    std::size_t _count;
+};
+
+} // namespace lxml
@@ -0,0 +1,65 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "BaseRecursiveHandler.h"
+#include "NumberParser.h"
+
+#include <cstdint>
+
+namespace lxml {
+
+/**
+ NumberHandler is a recursive handler that parses element contents as a
+ number of type `T`. The result is `0` when parsing fails, and `status()`
+ tells why. All sub-elements are ignored.
+ */
+template <typename T>
+class NumberHandler : public BaseRecursiveHandler<T> {
+public:
+    NumberHandler() : _status(NumberStatus::Empty) {
+        this->_result = T();
+    }
+    
+    /// The status of the last parsed element
+    NumberStatus status() const {
+        return _status;
+    }
+    
+    ContentPolicy contentPolicy() const {
+        return ContentPolicy::AccumulateTrimmed;
+    }
+    
+    void endElement(const QName& qname, std::string_view contents) {
+        this->_result = T();
+        _status = parseNumber(contents, this->_result);
+    }
+    
+protected:
+    NumberStatus _status;
+};
+
+typedef NumberHandler<std::int32_t> Int32Handler;
+typedef NumberHandler<std::int64_t> Int64Handler;
+typedef NumberHandler<std::uint64_t> UInt64Handler;
+typedef NumberHandler<float> FloatHandler;
+
+} // namespace lxml
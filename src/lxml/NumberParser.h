@@ -0,0 +1,79 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "Whitespace.h"
+
+#include <charconv>
+#include <string_view>
+#include <system_error>
+
+namespace lxml {
+
+/**
+ The outcome of parsing a number.
+ */
+enum class NumberStatus {
+    /// A number was parsed
+    Ok,
+    
+    /// The string was empty or all whitespace
+    Empty,
+    
+    /// The string is not a number, or has trailing characters
+    Invalid,
+    
+    /// The number does not fit in the requested type
+    Overflow
+};
+
+/**
+ Parse a number from a string with `std::from_chars`, skipping surrounding
+ XML whitespace and a leading `+`. Parsing does not depend on the locale and
+ does not allocate.
+ 
+ @param value Set to the parsed value. Left unchanged unless the status is
+              `NumberStatus::Ok`.
+ */
+template <typename T>
+NumberStatus parseNumber(std::string_view string, T& value) {
+    std::string_view trimmed = trim(string);
+    const char* first = trimmed.data();
+    const char* last = first + trimmed.size();
+    if (first == last)
+        return NumberStatus::Empty;
+    
+    // from_chars accepts a leading '-' but not a leading '+'
+    if (*first == '+' && last - first > 1 && first[1] != '-')
+        ++first;
+    
+    // Parse into a temporary, from_chars stores a valid prefix of invalid input
+    T parsed;
+    std::from_chars_result result = std::from_chars(first, last, parsed);
+    if (result.ec == std::errc::result_out_of_range)
+        return NumberStatus::Overflow;
+    if (result.ec != std::errc() || result.ptr != last)
+        return NumberStatus::Invalid;
+    value = parsed;
+    return NumberStatus::Ok;
+}
+
+} // namespace lxml
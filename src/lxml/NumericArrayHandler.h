@@ -0,0 +1,156 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "BaseRecursiveHandler.h"
+#include "NumberParser.h"
+#include "Whitespace.h"
+
+#include <string>
+#include <vector>
+
+namespace lxml {
+
+/**
+ NumericArrayHandler is a recursive handler that parses whitespace separated
+ numbers such as `<samples>1.2 3.4 5.6</samples>` as they are parsed, without
+ accumulating the element contents. Values are appended to the result vector,
+ or written to a caller-provided buffer set with `setBuffer`. Values that
+ fail to parse are stored as `0`. Sub-elements are ignored and separate
+ values.
+ */
+template <typename T>
+class NumericArrayHandler : public BaseRecursiveHandler<std::vector<T>> {
+public:
+    NumericArrayHandler() : _buffer(), _capacity(), _size(), _status(NumberStatus::Ok), _truncated() {}
+    
+    /**
+     Write values to `buffer` instead of the result vector. Values that do
+     not fit in `capacity` are dropped and `truncated()` is set. Pass a null
+     buffer to go back to the result vector.
+     */
+    void setBuffer(T* buffer, std::size_t capacity) {
+        _buffer = buffer;
+        _capacity = buffer ? capacity : 0;
+    }
+    
+    /// The number of values parsed from the last element
+    std::size_t size() const {
+        return _size;
+    }
+    
+    /// `NumberStatus::Ok`, or the status of the first value that failed to parse
+    NumberStatus status() const {
+        return _status;
+    }
+    
+    /// Whether values were dropped because the caller-provided buffer was full
+    bool truncated() const {
+        return _truncated;
+    }
+    
+    ContentPolicy contentPolicy() const {
+        return ContentPolicy::Stream;
+    }
+    
+    void startElement(const QName& qname, const AttributeView& attributes) {
+        this->_result.clear();
+        _partial.clear();
+        _size = 0;
+        _status = NumberStatus::Ok;
+        _truncated = false;
+    }
+    
+    void endElement(const QName& qname, std::string_view contents) {
+        flush();
+    }
+    
+    RecursiveHandler* startSubElement(const QName& qname) {
+        flush();
+        return 0;
+    }
+    
+    void characters(const char* chars, std::size_t length) {
+        const char* first = chars;
+        const char* last = chars + length;
+        
+        // Complete a value split across the previous chunk boundary
+        if (!_partial.empty()) {
+            const char* end = findSpace(first, last);
+            _partial.append(first, end);
+            if (end == last)
+                return;
+            flush();
+            first = end;
+        }
+        
+        while (true) {
+            first = skipSpace(first, last);
+            if (first == last)
+                break;
+            
+            const char* end = findSpace(first, last);
+            if (end == last) {
+                _partial.assign(first, last);
+                break;
+            }
+            add(first, end);
+            first = end;
+        }
+    }
+    
+private:
+    void flush() {
+        if (_partial.empty())
+            return;
+        add(_partial.data(), _partial.data() + _partial.size());
+        _partial.clear();
+    }
+    
+    void add(const char* first, const char* last) {
+        T value = T();
+        NumberStatus status = parseNumber(std::string_view(first, last - first), value);
+        if (status != NumberStatus::Ok && _status == NumberStatus::Ok)
+            _status = status;
+        
+        if (!_buffer) {
+            this->_result.push_back(value);
+        } else if (_size < _capacity) {
+            _buffer[_size] = value;
+        } else {
+            _truncated = true;
+            return;
+        }
+        _size += 1;
+    }
+    
+private:
+    T* _buffer;
+    std::size_t _capacity;
+    std::size_t _size;
+    NumberStatus _status;
+    bool _truncated;
+    
+    /// The start of a value that continues in the next chunk
+    std::string _partial;
+};
+
+} // namespace lxml
@@ -0,0 +1,179 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "ParallelParser.h"
+#include "MappedFile.h"
+#include "RecordScanner.h"
+#include "Wait.h"
+
+#include <algorithm>
+#include <functional>
+#include <libxml/parser.h>
+#include <mutex>
+#include <thread>
+
+namespace lxml {
+
+enum class ChunkStatus {
+    Pending,
+    Parsed,
+    Failed
+};
+
+/**
+ Joins worker threads when it goes out of scope, after calling a function
+ that tells them to stop. This keeps an exception thrown while delivering
+ records from destroying running threads.
+ */
+class ThreadJoiner {
+public:
+    explicit ThreadJoiner(std::function<void()> stop) : _stop(std::move(stop)) {}
+    ~ThreadJoiner() {
+        _stop();
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+    
+    std::vector<std::thread> threads;
+    
+private:
+    std::function<void()> _stop;
+};
+
+ParallelParser::ParallelParser(const ParallelOptions& options) : _options(options), _chunkCount() {
+    // libxml2 must be initialized before threads use it
+    xmlInitParser();
+
+    if (_options.threads == 0)
+        _options.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (_options.maxPendingChunks == 0)
+        _options.maxPendingChunks = 2 * _options.threads;
+}
+
+bool ParallelParser::parseFile(const std::string& path, const char* recordName, const WorkerFactory& makeWorker) {
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    return parse(file.data(), file.size(), path, recordName, makeWorker);
+}
+
+bool ParallelParser::parse(const char* data, std::size_t length, const std::string& filename, const char* recordName, const WorkerFactory& makeWorker) {
+    RecordLayout layout;
+    RecordScanner scanner(data, length);
+    bool split = _options.threads > 1 && scanner.scan(recordName, _options.chunkSize, layout) && layout.splits.size() > 2;
+    if (!split) {
+        _chunkCount = 1;
+        Parser parser(_options.parseOptions);
+        std::unique_ptr<RecordWorker> worker = makeWorker();
+        return worker->parse(parser, data, length, filename, 0);
+    }
+
+    const std::size_t chunkCount = layout.splits.size() - 1;
+    const std::size_t threadCount = std::min(_options.threads, chunkCount);
+    _chunkCount = chunkCount;
+
+    std::vector<std::unique_ptr<RecordWorker>> workers;
+    for (std::size_t i = 0; i < threadCount; i += 1)
+        workers.push_back(makeWorker());
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<std::unique_ptr<RecordBatch>> batches(chunkCount);
+    std::vector<ChunkStatus> status(chunkCount, ChunkStatus::Pending);
+    std::size_t nextChunk = 0;
+    std::size_t delivered = 0;
+    bool failed = false;
+
+    auto work = [&](RecordWorker* worker) {
+        Parser parser(_options.parseOptions);
+        std::string document;
+        while (true) {
+            std::size_t chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                waitUntil(condition, lock, [&]() {
+                    return failed || nextChunk == chunkCount || nextChunk < delivered + _options.maxPendingChunks;
+                });
+                if (failed || nextChunk == chunkCount)
+                    return;
+                chunk = nextChunk++;
+            }
+
+            // libxml2 needs contiguous input, the copy is cheap next to parsing
+            std::size_t begin = layout.splits[chunk];
+            std::size_t end = layout.splits[chunk + 1];
+            document.assign(data, layout.preludeLength);
+            document.append(data + begin, end - begin);
+            document.append(layout.suffix);
+
+            std::unique_ptr<RecordBatch> batch;
+            bool result = worker->parse(parser, document.data(), document.size(), filename, &batch);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            batches[chunk] = std::move(batch);
+            status[chunk] = result ? ChunkStatus::Parsed : ChunkStatus::Failed;
+            failed = failed || !result;
+            condition.notify_all();
+        }
+    };
+
+    // Stop workers waiting for delivery to move on, also when delivery ends
+    // early or throws
+    ThreadJoiner joiner([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        failed = failed || delivered < chunkCount;
+        condition.notify_all();
+    });
+    for (std::size_t i = 0; i < threadCount; i += 1)
+        joiner.threads.emplace_back(work, workers[i].get());
+
+    // Deliver on this thread in document order. After a failure, deliver
+    // the chunks that were parsed up to and including the failed one.
+    for (std::size_t chunk = 0; chunk < chunkCount; chunk += 1) {
+        std::unique_ptr<RecordBatch> batch;
+        ChunkStatus chunkStatus;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            waitUntil(condition, lock, [&]() {
+                return status[chunk] != ChunkStatus::Pending || (failed && chunk >= nextChunk);
+            });
+            chunkStatus = status[chunk];
+            batch = std::move(batches[chunk]);
+        }
+        if (chunkStatus == ChunkStatus::Pending)
+            break;
+
+        if (batch)
+            batch->deliver();
+        if (chunkStatus == ChunkStatus::Failed)
+            break;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        delivered = chunk + 1;
+        condition.notify_all();
+    }
+
+    // Every chunk was parsed and delivered, or delivery stopped at a failure
+    std::lock_guard<std::mutex> lock(mutex);
+    return !failed && delivered == chunkCount;
+}
+
+} // namespace lxml
@@ -0,0 +1,225 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "BaseRecursiveHandler.h"
+#include "ParseOptions.h"
+#include "Parser.h"
+#include "QName.h"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lxml {
+
+/**
+ Options for ParallelParser.
+ */
+struct ParallelOptions {
+    /// The number of worker threads, `0` for one per hardware thread
+    std::size_t threads;
+    
+    /// The minimum size of the slice of the document parsed by each task
+    std::size_t chunkSize;
+    
+    /// How many chunks may be parsed ahead of the one being delivered, `0`
+    /// for twice the number of threads
+    std::size_t maxPendingChunks;
+    
+    /// Options for the parser of each worker thread
+    ParseOptions parseOptions;
+    
+    ParallelOptions() : threads(), chunkSize(8 * 1024 * 1024), maxPendingChunks() {}
+};
+
+/**
+ The records parsed from one chunk, waiting to be delivered in order.
+ */
+class RecordBatch {
+public:
+    virtual ~RecordBatch() {}
+    virtual void deliver() = 0;
+};
+
+/**
+ A RecordWorker parses chunks on one thread. It is what ParallelParser uses
+ to stay independent of the record type, see ParallelParser::parseRecords
+ for the typed interface.
+ */
+class RecordWorker {
+public:
+    virtual ~RecordWorker() {}
+    
+    /**
+     Parse a chunk document and collect its records into `batch`, or deliver
+     them right away if `batch` is null.
+     */
+    virtual bool parse(Parser& parser, const char* data, std::size_t length, const std::string& filename, std::unique_ptr<RecordBatch>* batch) = 0;
+};
+
+/**
+ ParallelParser parses a large document made of many sibling records, such
+ as `<root><record/><record/>...</root>`, on several threads.
+ 
+ A pre-scan (see RecordScanner) splits the document at record boundaries.
+ Each slice is parsed as its own document, made of the text before the
+ first record, the slice and the closing tags of the enclosing elements.
+ Every worker thread has its own Parser and record handler. Records are
+ delivered on the calling thread in document order, and workers stay at
+ most `maxPendingChunks` ahead of delivery.
+ 
+ When the document can't be split safely, or is smaller than two chunks,
+ it is parsed sequentially on the calling thread with the same handlers
+ and records are delivered as they are parsed.
+ */
+class ParallelParser {
+public:
+    typedef std::function<std::unique_ptr<RecordWorker>()> WorkerFactory;
+    
+public:
+    explicit ParallelParser(const ParallelOptions& options = ParallelOptions());
+    
+    const ParallelOptions& options() const {
+        return _options;
+    }
+    
+    /// The number of chunks the last document was parsed in, `1` if it was
+    /// parsed sequentially
+    std::size_t chunkCount() const {
+        return _chunkCount;
+    }
+    
+    /**
+     Parse records in memory, calling `onRecord` with each record's result
+     in document order. `makeHandler` is called once per worker thread on
+     the calling thread. Elements with the local name of `record` (at any
+     depth) are parsed with the handler, other elements are ignored. Records
+     are matched by local name only, whatever their prefix or namespace,
+     because that's all the pre-scan can see without resolving namespaces.
+     
+     If `onRecord` throws, the worker threads are stopped and joined before
+     the exception propagates.
+     
+     @return `true` if parsing is successful, `false` if there is an error
+             parsing. Records before the error are still delivered.
+     */
+    template <typename T>
+    bool parseRecords(const char* data, std::size_t length, const std::string& filename, const QName& record,
+                      std::function<std::unique_ptr<BaseRecursiveHandler<T>>()> makeHandler,
+                      std::function<void(T&&)> onRecord) {
+        return parse(data, length, filename, record.localName(), [&]() {
+            return std::unique_ptr<RecordWorker>(new TypedRecordWorker<T>(record, makeHandler(), onRecord));
+        });
+    }
+    
+    /**
+     Parse records in a memory mapped file. See the in memory version.
+     
+     @return `true` if parsing is successful, `false` if the file can't be
+             opened or there is an error parsing.
+     */
+    template <typename T>
+    bool parseRecordsFile(const std::string& path, const QName& record,
+                          std::function<std::unique_ptr<BaseRecursiveHandler<T>>()> makeHandler,
+                          std::function<void(T&&)> onRecord) {
+        return parseFile(path, record.localName(), [&]() {
+            return std::unique_ptr<RecordWorker>(new TypedRecordWorker<T>(record, makeHandler(), onRecord));
+        });
+    }
+    
+    bool parse(const char* data, std::size_t length, const std::string& filename, const char* recordName, const WorkerFactory& makeWorker);
+    bool parseFile(const std::string& path, const char* recordName, const WorkerFactory& makeWorker);
+    
+private:
+    template <typename T>
+    class TypedRecordWorker : public RecordWorker {
+    public:
+        TypedRecordWorker(const QName& record, std::unique_ptr<BaseRecursiveHandler<T>> handler, const std::function<void(T&&)>& onRecord)
+        : _collector(record, std::move(handler), onRecord) {}
+        
+        bool parse(Parser& parser, const char* data, std::size_t length, const std::string& filename, std::unique_ptr<RecordBatch>* batch) {
+            Batch* records = 0;
+            if (batch) {
+                records = new Batch(_collector.onRecord);
+                batch->reset(records);
+            }
+            _collector.records = records ? &records->records : 0;
+            return parser.parse(data, length, filename, _collector);
+        }
+        
+    private:
+        struct Batch : public RecordBatch {
+            std::vector<T> records;
+            const std::function<void(T&&)>& onRecord;
+            
+            explicit Batch(const std::function<void(T&&)>& onRecord) : onRecord(onRecord) {}
+            void deliver() {
+                for (T& record : records)
+                    onRecord(std::move(record));
+            }
+        };
+        
+        /// Descends into every element until it finds a record
+        struct Collector : public RecursiveHandler {
+            QName record;
+            std::unique_ptr<BaseRecursiveHandler<T>> handler;
+            const std::function<void(T&&)>& onRecord;
+            std::vector<T>* records;
+            
+            Collector(const QName& record, std::unique_ptr<BaseRecursiveHandler<T>> handler, const std::function<void(T&&)>& onRecord)
+            : record(record), handler(std::move(handler)), onRecord(onRecord), records() {}
+            
+            ContentPolicy contentPolicy() const {
+                return ContentPolicy::Ignore;
+            }
+            void startElement(const QName& qname, const AttributeView& attributes) {}
+            void endElement(const QName& qname, std::string_view contents) {}
+            
+            RecursiveHandler* startSubElement(const QName& qname) {
+                // Match records the way RecordScanner splits them
+                if (std::strcmp(qname.localName(), record.localName()) == 0)
+                    return handler.get();
+                return this;
+            }
+            
+            void endSubElement(const QName& qname, RecursiveHandler* subHandler) {
+                if (subHandler != handler.get())
+                    return;
+                if (records)
+                    records->push_back(handler->result());
+                else
+                    onRecord(handler->result());
+            }
+        };
+        
+        Collector _collector;
+    };
+    
+private:
+    ParallelOptions _options;
+    std::size_t _chunkCount;
+};
+
+} // namespace lxml
@@ -0,0 +1,63 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "ParseContext.h"
+#include "ParseState.h"
+
+namespace lxml {
+
+static thread_local ParseContext* __current_context = 0;
+
+ParseContext::Scope::Scope(ParseContext& context) : _previous(__current_context) {
+    __current_context = &context;
+}
+
+ParseContext::Scope::~Scope() {
+    __current_context = _previous;
+}
+
+ParseContext::ParseContext() : _resource(std::pmr::get_default_resource()), _arena(), _state() {
+}
+
+ParseContext* ParseContext::current() {
+    return __current_context;
+}
+
+void ParseContext::setResource(std::pmr::memory_resource* resource, bool arena) {
+    _resource = resource ? resource : std::pmr::get_default_resource();
+    _arena = resource && arena;
+}
+
+void ParseContext::skipSubtree() {
+    if (_state)
+        _state->skipRequested = true;
+}
+
+void ParseContext::stop() {
+    if (_state)
+        _state->stop(ParseStatus::Stopped);
+}
+
+ParseStats* ParseContext::stats() const {
+    return _state ? _state->stats : 0;
+}
+
+} // namespace lxml
@@ -0,0 +1,131 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <memory_resource>
+
+namespace lxml {
+
+struct ParseState;
+struct ParseStats;
+
+/**
+ ParseContext holds per-document state that handlers can reach while a
+ document is being parsed. Use `ParseContext::current()` from inside any
+ handler callback.
+ 
+ When parsing with `ParseOptions::useArena`, `resource()` is a monotonic
+ arena owned by the Parser. Everything allocated from it is released in one
+ shot when the parser starts its next document or is destroyed, so results
+ allocated from the arena must not outlive the parser or be kept across
+ documents. Without an arena `resource()` is the default memory resource.
+ 
+ A handler that has no use for an element's contents can call
+ `skipSubtree()` from its start element callback. The element's children,
+ text and attributes are then scanned by libxml2 without calling back into
+ lxml, and the next event is the element's own end. Once a handler has
+ what it needs it can end the whole parse early with `stop()`.
+ */
+class ParseContext {
+public:
+    /**
+     Makes a context current on this thread for the lifetime of the scope.
+     */
+    class Scope {
+    public:
+        explicit Scope(ParseContext& context);
+        ~Scope();
+        
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        
+    private:
+        ParseContext* _previous;
+    };
+    
+public:
+    ParseContext();
+    
+    ParseContext(const ParseContext&) = delete;
+    ParseContext& operator=(const ParseContext&) = delete;
+    
+    /**
+     The context of the document being parsed on this thread, or `0` when
+     called outside of a parse.
+     */
+    static ParseContext* current();
+    
+    /**
+     The memory resource to allocate per-document data from.
+     */
+    std::pmr::memory_resource* resource() const {
+        return _resource;
+    }
+    
+    /**
+     Whether `resource()` is a per-document arena.
+     */
+    bool hasArena() const {
+        return _arena;
+    }
+    
+    /**
+     An allocator for per-document containers, for instance
+     `std::pmr::vector<int> values(context->allocator<int>())`.
+     */
+    template <typename T>
+    std::pmr::polymorphic_allocator<T> allocator() const {
+        return std::pmr::polymorphic_allocator<T>(_resource);
+    }
+    
+    /**
+     Set the memory resource. Pass `0` to use the default resource.
+     */
+    void setResource(std::pmr::memory_resource* resource, bool arena);
+    
+    /**
+     Skip everything inside the element being started. Only has an effect
+     when called from a start element callback.
+     */
+    void skipSubtree();
+    
+    /**
+     Stop parsing after the current callback. No more events are delivered
+     and the parse ends with `ParseStatus::Stopped`.
+     */
+    void stop();
+    
+    /**
+     The statistics being collected for this document, or `0` when the
+     parser doesn't collect statistics.
+     */
+    ParseStats* stats() const;
+    
+private:
+    friend class Parser;
+    friend class EventTape;
+    
+    std::pmr::memory_resource* _resource;
+    bool _arena;
+    ParseState* _state;
+};
+
+} // namespace lxml
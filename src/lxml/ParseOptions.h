@@ -0,0 +1,127 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+namespace lxml {
+
+class CancellationToken;
+class SymbolTable;
+
+/**
+ ParseOptions holds optional settings for a parse. The defaults match the
+ behavior of a plain `parse` call.
+ 
+ A parse aborted by a cancellation or a budget returns `false` like one
+ that failed. `Parser::status()`, or the `status` argument of the free
+ parse functions, tells which.
+ */
+struct ParseOptions {
+    ParseOptions()
+    : symbols(), useArena(), arenaBlockSize(64*1024), readAhead(), readAheadBufferSize(1024*1024), readAheadDepth(4), decompress(true),
+      cancel(), maxBytes(), maxElements(), maxDepth(), timeout(), collectStats() {}
+    
+    /**
+     Intern the names delivered to handlers that are registered in this
+     table, so that they can be compared to the table's symbols by pointer.
+     Other names are compared by content. The table must outlive the parse
+     and must not be modified during it.
+     */
+    const SymbolTable* symbols;
+    
+    /**
+     Allocate lxml's per-document buffers from a monotonic arena that is
+     released in one shot when the parser starts its next document. Handlers
+     can allocate from the same arena through ParseContext.
+     */
+    bool useArena;
+    
+    /**
+     The size of the arena's first block, later blocks grow geometrically.
+     */
+    std::size_t arenaBlockSize;
+    
+    /**
+     Read streams on a background thread so that the parser doesn't wait
+     for every read. Worth it for large documents on slow or high latency
+     streams such as pipes and network file systems. See
+     Parser::readAheadStats for stall metrics.
+     */
+    bool readAhead;
+    
+    /**
+     The size of each read-ahead buffer.
+     */
+    std::size_t readAheadBufferSize;
+    
+    /**
+     The number of read-ahead buffers, including the one being parsed.
+     */
+    std::size_t readAheadDepth;
+    
+    /**
+     Decompress gzip and zstd input, detected from its first bytes. The
+     input is decompressed on a background thread into the read-ahead
+     buffers, whether or not `readAhead` is set.
+     */
+    bool decompress;
+    
+    /**
+     Abort the parse with `ParseStatus::Cancelled` when this token is
+     cancelled from any thread. The token must outlive the parse.
+     */
+    const CancellationToken* cancel;
+    
+    /**
+     Abort the parse with `ParseStatus::MaxBytes` before more than this many
+     bytes of XML, after decompression, are parsed. `0` means no limit.
+     */
+    std::size_t maxBytes;
+    
+    /**
+     Abort the parse with `ParseStatus::MaxElements` at the element after
+     this many. Elements in skipped subtrees count too. `0` means no limit.
+     */
+    std::size_t maxElements;
+    
+    /**
+     Abort the parse with `ParseStatus::MaxDepth` at an element nested
+     deeper than this, the document element being at depth 1. `0` means no
+     limit.
+     */
+    std::size_t maxDepth;
+    
+    /**
+     Abort the parse with `ParseStatus::Timeout` once it has run for this
+     long. Checked before each chunk of input. Zero means no limit.
+     */
+    std::chrono::steady_clock::duration timeout;
+    
+    /**
+     Collect ParseStats, see Parser::stats. Parsers built without it run
+     callbacks that have no statistics code at all.
+     */
+    bool collectStats;
+};
+
+} // namespace lxml
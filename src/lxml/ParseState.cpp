@@ -0,0 +1,81 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "ParseState.h"
+
+namespace lxml {
+
+static ParseState* parseState(void* ctx) {
+    return static_cast<ParseState*>(ctx);
+}
+
+static void skipEndDocument(void* ctx) {
+    ParseState* state = parseState(ctx);
+    state->stopSkipping();
+    if (state->sax->endDocument)
+        state->sax->endDocument(ctx);
+}
+
+static void skipStartElementNs(void* ctx, const xmlChar*, const xmlChar*, const xmlChar*, int, const xmlChar**, int, int, const xmlChar**) {
+    ParseState* state = parseState(ctx);
+    if (state->checkElement())
+        ++state->skipDepth;
+}
+
+static void skipEndElementNs(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* URI) {
+    ParseState* state = parseState(ctx);
+    if (--state->skipDepth != 0)
+        return;
+    
+    // The skipped element itself ends with the handler's callbacks
+    state->stopSkipping();
+    if (state->sax->endElementNs)
+        state->sax->endElementNs(ctx, localname, prefix, URI);
+}
+
+static void skipError(void* ctx, ParseErrorPtr error) {
+    ParseState* state = parseState(ctx);
+    if (state->sax->serror)
+        state->sax->serror(ctx, error);
+}
+
+// Text, comments and processing instructions have no callbacks, libxml2 only
+// scans past them
+static const xmlSAXHandler __skip_handler = [] {
+    xmlSAXHandler sax = xmlSAXHandler();
+    sax.initialized = XML_SAX2_MAGIC;
+    sax.endDocument = skipEndDocument;
+    sax.startElementNs = skipStartElementNs;
+    sax.endElementNs = skipEndElementNs;
+    sax.serror = skipError;
+    return sax;
+}();
+
+void ParseState::startSkipping() {
+    skipRequested = false;
+    if (!context || !sax || context->sax != sax)
+        return;
+    
+    skipDepth = 1;
+    context->sax = const_cast<xmlSAXHandler*>(&__skip_handler);
+}
+
+} // namespace lxml
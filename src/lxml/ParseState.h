@@ -0,0 +1,248 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "ParseStats.h"
+#include "ParseStatus.h"
+#include "QName.h"
+#include "SymbolTable.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <libxml/parser.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace lxml {
+
+/**
+ ParseState is the user data that libxml2 passes to lxml's callbacks. It is
+ an implementation detail shared by Parser and the statically dispatched
+ callbacks in StaticSAXHandler.h.
+ */
+struct ParseState {
+    ParseState() : handler(), symbols(), context(), sax(), skipRequested(), skipDepth(), status(), elements(), maxElements(-1), maxDepth(-1), stats(), handlerTicks(), callbacks(), sampledCallbacks(), sampler(1), countdown(1) {}
+    
+    /// The handler receiving events, its type depends on the callbacks
+    void* handler;
+    
+    /// The SymbolTable names are interned against, if any
+    const SymbolTable* symbols;
+    
+    /// The context being parsed and its own callback table
+    xmlParserCtxtPtr context;
+    xmlSAXHandler* sax;
+    
+    /// Set by `ParseContext::skipSubtree()` during a start element callback
+    bool skipRequested;
+    
+    /// Open elements in the subtree being skipped, including its root
+    std::size_t skipDepth;
+    
+    /// How the parse is going, anything but `Ok` stops it
+    ParseStatus status;
+    
+    /// Elements started so far and the budgets, unlimited is the maximum
+    std::size_t elements;
+    std::size_t maxElements;
+    std::size_t maxDepth;
+    
+    /// Statistics being collected, `0` unless collecting
+    ParseStats* stats;
+    
+    /// Time spent in the sampled handler callbacks, in `ticks()`
+    std::uint64_t handlerTicks;
+    std::uint64_t callbacks;
+    std::uint64_t sampledCallbacks;
+    
+    /// Random state choosing the callbacks to time
+    std::uint32_t sampler;
+    
+    /// Callbacks left until the next timed one
+    std::uint32_t countdown;
+    
+    /**
+     Call before a start element callback. Requests made outside of start
+     element callbacks are dropped.
+     
+     @return `false` if the element is over budget and the callback must
+             not be called.
+     */
+    bool willStartElement() {
+        skipRequested = false;
+        return checkElement();
+    }
+    
+    /**
+     Count an element against the budgets. libxml2 pushes an element on its
+     name stack after the start callback, so `nameNr` is the parent's depth.
+     */
+    bool checkElement() {
+        if (++elements > maxElements)
+            return stop(ParseStatus::MaxElements);
+        if (static_cast<std::size_t>(context->nameNr) >= maxDepth)
+            return stop(ParseStatus::MaxDepth);
+        return true;
+    }
+    
+    /**
+     Stop parsing, keeping the first reason given.
+     
+     @return `false` for convenience.
+     */
+    bool stop(ParseStatus reason) {
+        if (status == ParseStatus::Ok)
+            status = reason;
+        if (context)
+            xmlStopParser(context);
+        return false;
+    }
+    
+    /**
+     Call after a start element callback. If the handler asked to skip the
+     element, libxml2 is switched to callbacks that only track depth until
+     the element ends. The element's own end event is still delivered.
+     */
+    void didStartElement() {
+        if (skipRequested)
+            startSkipping();
+    }
+    
+    /**
+     Switch back to the handler's callbacks. Must be called before the
+     context is reset or freed.
+     */
+    void stopSkipping() {
+        if (context && sax)
+            context->sax = sax;
+        skipRequested = false;
+        skipDepth = 0;
+    }
+    
+    void startSkipping();
+    
+    QName qname(const xmlChar* localname, const xmlChar* prefix, const xmlChar* URI) const {
+        if (symbols)
+            return symbols->qname(reinterpret_cast<const char*>(localname),
+                                  reinterpret_cast<const char*>(prefix),
+                                  reinterpret_cast<const char*>(URI));
+        return QName(reinterpret_cast<const char*>(localname),
+                     reinterpret_cast<const char*>(prefix),
+                     reinterpret_cast<const char*>(URI));
+    }
+};
+
+/**
+ A cheap monotonic counter for timing callbacks. Its frequency is
+ calibrated against the steady clock over a whole parse.
+ */
+inline std::uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ Statistics policy for the callbacks that doesn't collect anything. All of
+ its hooks compile away.
+ */
+struct NoStats {
+    /** Whether handlers without startElement still need element callbacks */
+    static constexpr bool countsElements = false;
+
+    struct Timer {
+        explicit Timer(ParseState&) {}
+    };
+    
+    static void startElement(ParseState&, int) {}
+    static void characters(ParseState&, int) {}
+};
+
+/**
+ Policy for parsers with element budgets but no statistics. Like NoStats,
+ but elements are always seen so that they count against the budgets.
+ */
+struct CountElements : NoStats {
+    static constexpr bool countsElements = true;
+};
+
+/**
+ Statistics policy for the callbacks that fills in the parse state's
+ ParseStats and times handler callbacks.
+ 
+ Reading the time stamp counter costs about as much as a small callback on
+ some virtual machines, so only about one callback in 32 is timed and the
+ total is extrapolated. The gap to the next timed callback is random to avoid
+ lining up with repeating document structure, and drawing it only when a
+ sample is taken keeps the untimed callbacks down to a counter decrement.
+ */
+struct CollectStats {
+    static constexpr bool countsElements = true;
+
+    class Timer {
+    public:
+        explicit Timer(ParseState& state) : _state(state), _start() {
+            ++state.callbacks;
+            if (--state.countdown == 0) {
+                std::uint32_t x = state.sampler;
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                state.sampler = x;
+                state.countdown = (x & 63) + 1;
+                ++state.sampledCallbacks;
+                _start = ticks();
+            }
+        }
+        ~Timer() {
+            if (_start)
+                _state.handlerTicks += ticks() - _start;
+        }
+        
+    private:
+        ParseState& _state;
+        std::uint64_t _start;
+    };
+    
+    static void startElement(ParseState& state, int attributes) {
+        state.stats->attributes += static_cast<std::size_t>(attributes);
+        std::size_t depth = static_cast<std::size_t>(state.context->nameNr) + 1;
+        if (depth > state.stats->maxDepth)
+            state.stats->maxDepth = depth;
+    }
+    
+    static void characters(ParseState& state, int length) {
+        state.stats->textBytes += static_cast<std::size_t>(length);
+    }
+};
+
+#if LIBXML_VERSION >= 21200
+typedef const xmlError* ParseErrorPtr;
+#else
+typedef xmlErrorPtr ParseErrorPtr;
+#endif
+
+} // namespace lxml
@@ -0,0 +1,111 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace lxml {
+
+/**
+ ParseStats describes where the last parse spent its time and memory. It
+ is filled in by Parser when `ParseOptions::collectStats` is set.
+ */
+struct ParseStats {
+    ParseStats()
+    : bytes(), chunks(), elements(), attributes(), textBytes(), maxDepth(), parseSeconds(), handlerSeconds(), contentAllocations(), attributeMapAllocations() {}
+    
+    /// Bytes of XML handed to libxml2, after decompression
+    std::size_t bytes;
+    
+    /// Calls to libxml2's parser, one per chunk of input
+    std::size_t chunks;
+    
+    /// Elements parsed, including those in skipped subtrees
+    std::size_t elements;
+    
+    /// Attributes of the elements delivered to the handler
+    std::size_t attributes;
+    
+    /// Text delivered to the handler
+    std::size_t textBytes;
+    
+    /// The deepest element delivered to the handler, the document element
+    /// being at depth 1
+    std::size_t maxDepth;
+    
+    /// Time spent in libxml2's parser, callbacks included
+    double parseSeconds;
+    
+    /// Time spent in handler callbacks
+    double handlerSeconds;
+    
+    /// Allocations of recursive handler stacks and content buffers
+    std::size_t contentAllocations;
+    
+    /// Allocations of maps built by `AttributeView::toMap`
+    std::size_t attributeMapAllocations;
+    
+    /**
+     Time spent in libxml2 itself.
+     */
+    double libxmlSeconds() const {
+        return parseSeconds - handlerSeconds;
+    }
+};
+
+/**
+ A memory resource that counts the allocations it forwards upstream.
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+    : _upstream(upstream), _allocations() {}
+    
+    void setUpstream(std::pmr::memory_resource* upstream) {
+        _upstream = upstream;
+    }
+    
+    std::size_t allocations() const {
+        return _allocations;
+    }
+    
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) {
+        ++_allocations;
+        return _upstream->allocate(bytes, alignment);
+    }
+    
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) {
+        _upstream->deallocate(pointer, bytes, alignment);
+    }
+    
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+    
+private:
+    std::pmr::memory_resource* _upstream;
+    std::size_t _allocations;
+};
+
+} // namespace lxml
@@ -0,0 +1,90 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <atomic>
+
+namespace lxml {
+
+/**
+ ParseStatus says how the last parse ended.
+ */
+enum class ParseStatus {
+    /// The whole document was parsed
+    Ok,
+    
+    /// The document is not well formed, is incomplete or can't be read
+    Error,
+    
+    /// A handler called `ParseContext::stop()`
+    Stopped,
+    
+    /// The CancellationToken in ParseOptions was cancelled
+    Cancelled,
+    
+    /// The document is longer than `ParseOptions::maxBytes`
+    MaxBytes,
+    
+    /// The document has more than `ParseOptions::maxElements` elements
+    MaxElements,
+    
+    /// Elements are nested deeper than `ParseOptions::maxDepth`
+    MaxDepth,
+    
+    /// Parsing took longer than `ParseOptions::timeout`
+    Timeout,
+    
+    /// The document is compressed in a format lxml was built without
+    Unsupported
+};
+
+/**
+ CancellationToken lets any thread abort the parses that were started with
+ it in their ParseOptions. Parsers check the token before each chunk of
+ input they hand to libxml2.
+ */
+class CancellationToken {
+public:
+    CancellationToken() : _cancelled(false) {}
+    
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+    
+    void cancel() {
+        _cancelled.store(true, std::memory_order_relaxed);
+    }
+    
+    bool cancelled() const {
+        return _cancelled.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     Make the token usable again, for instance before starting a new batch.
+     */
+    void reset() {
+        _cancelled.store(false, std::memory_order_relaxed);
+    }
+    
+private:
+    std::atomic<bool> _cancelled;
+};
+
+} // namespace lxml
@@ -0,0 +1,455 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "Parser.h"
+#include "ParseStatus.h"
+#include "Decompressor.h"
+#include "MappedFile.h"
+#include "ParseState.h"
+#include "SymbolTable.h"
+
+#include <algorithm>
+
+namespace lxml {
+
+static const std::size_t kReadChunkSize = 10*1024;
+static const std::size_t kMemoryChunkSize = 256*1024;
+
+// Recycled contexts keep their dictionary, start afresh when it gets this big
+static const std::size_t kMaxDictionarySize = 64*1024;
+
+/**
+ libxml2 callbacks that forward to a SAXHandler. `Stats` is NoStats or
+ CollectStats.
+ */
+template <typename Stats>
+struct SAXCallbacks {
+    static SAXHandler* saxHandler(void* ctx) {
+        return static_cast<SAXHandler*>(static_cast<ParseState*>(ctx)->handler);
+    }
+
+    static void startDocument(void* ctx) {
+        saxHandler(ctx)->startDocument();
+    }
+
+    static void endDocument(void* ctx) {
+        saxHandler(ctx)->endDocument();
+    }
+
+    static void startElementNs(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* URI, int nb_namespaces, const xmlChar** namespaces, int nb_attributes, int nb_defaulted, const xmlChar** attributes) {
+        ParseState* state = static_cast<ParseState*>(ctx);
+        if (!state->willStartElement())
+            return;
+        Stats::startElement(*state, nb_attributes);
+        {
+            typename Stats::Timer timer(*state);
+            saxHandler(ctx)->startElement(state->qname(localname, prefix, URI),
+                                          NamespaceView(namespaces, nb_namespaces),
+                                          AttributeView(attributes, nb_attributes, state->symbols));
+        }
+        state->didStartElement();
+    }
+
+    static void endElementNs(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* URI) {
+        ParseState* state = static_cast<ParseState*>(ctx);
+        typename Stats::Timer timer(*state);
+        saxHandler(ctx)->endElement(state->qname(localname, prefix, URI));
+    }
+
+    static void characters(void* ctx, const xmlChar* ch, int len) {
+        ParseState* state = static_cast<ParseState*>(ctx);
+        Stats::characters(*state, len);
+        typename Stats::Timer timer(*state);
+        saxHandler(ctx)->characters(reinterpret_cast<const char*>(ch), static_cast<std::size_t>(len));
+    }
+
+    static void error(void* ctx, ParseErrorPtr error) {
+        saxHandler(ctx)->error(*error);
+    }
+
+    static const xmlSAXHandler& table() {
+        static const xmlSAXHandler sax = makeTable();
+        return sax;
+    }
+
+    static xmlSAXHandler makeTable() {
+        xmlSAXHandler sax = xmlSAXHandler();
+        sax.initialized = XML_SAX2_MAGIC;
+        sax.startDocument = startDocument;
+        sax.endDocument = endDocument;
+        sax.startElementNs = startElementNs;
+        sax.endElementNs = endElementNs;
+        sax.characters = characters;
+        sax.serror = error;
+        return sax;
+    }
+};
+
+/**
+ Replace the context's private dictionary with a sub-dictionary of a
+ symbol table so that names are interned against the table's symbols.
+ */
+static void useSymbolTable(xmlParserCtxtPtr parserCtxt, const SymbolTable& symbols) {
+    xmlDictFree(parserCtxt->dict);
+    parserCtxt->dict = xmlDictCreateSub(symbols.dict());
+    parserCtxt->dictNames = 1;
+
+    // These are looked up in the dictionary when the context is created
+    parserCtxt->str_xml = xmlDictLookup(parserCtxt->dict, BAD_CAST "xml", 3);
+    parserCtxt->str_xmlns = xmlDictLookup(parserCtxt->dict, BAD_CAST "xmlns", 5);
+    parserCtxt->str_xml_ns = xmlDictLookup(parserCtxt->dict, XML_XML_NAMESPACE, 36);
+}
+
+/**
+ Report an error found by lxml rather than libxml2 to the handler's error
+ callback, the way libxml2 reports I/O errors.
+ */
+static void reportError(const xmlSAXHandler& sax, ParseState& state, const std::string& filename, const char* message) {
+    if (!sax.serror)
+        return;
+
+    xmlError error = xmlError();
+    error.domain = XML_FROM_IO;
+    error.code = XML_IO_UNKNOWN;
+    error.level = XML_ERR_FATAL;
+    error.message = const_cast<char*>(message);
+    error.file = const_cast<char*>(filename.c_str());
+    sax.serror(&state, &error);
+}
+
+Parser::Parser() : _state(new ParseState), _context(), _bytes(), _parseTicks(), _startTicks(), _endTicks(), _startContentAllocations() {
+    _parseContext._state = _state.get();
+}
+
+// A DOCTYPE makes libxml2 build a document for the DTD even without a tree
+// builder, and freeing the context doesn't free it
+static void freeContext(xmlParserCtxtPtr context) {
+    if (context->myDoc) {
+        xmlFreeDoc(context->myDoc);
+        context->myDoc = NULL;
+    }
+    xmlFreeParserCtxt(context);
+}
+
+Parser::Parser(const ParseOptions& options) : _options(options), _state(new ParseState), _context(), _bytes(), _parseTicks(), _startTicks(), _endTicks(), _startContentAllocations() {
+    _parseContext._state = _state.get();
+    _state->symbols = options.symbols;
+    if (options.useArena) {
+        _arena.reset(new std::pmr::monotonic_buffer_resource(options.arenaBlockSize));
+        _parseContext.setResource(_arena.get(), true);
+        _statsResource.setUpstream(_arena.get());
+    }
+    if (options.collectStats) {
+        _state->stats = &_stats;
+        _rootHandler.setMemoryResource(&_statsResource);
+    }
+}
+
+Parser::~Parser() {
+    _state->stopSkipping();
+    if (_context)
+        freeContext(_context);
+}
+
+void Parser::releaseArena() {
+    if (!_arena)
+        return;
+    
+    _rootHandler.setMemoryResource(std::pmr::get_default_resource());
+    _arena->release();
+    if (_options.collectStats)
+        _rootHandler.setMemoryResource(&_statsResource);
+    else
+        _rootHandler.setMemoryResource(_arena.get());
+}
+
+bool Parser::begin(const std::string& filename, const xmlSAXHandler& sax, void* handler) {
+    _state->handler = handler;
+    _state->stopSkipping();
+    _state->context = NULL;
+    _state->status = ParseStatus::Ok;
+    _state->elements = 0;
+    _state->maxElements = _options.maxElements ? _options.maxElements : static_cast<std::size_t>(-1);
+    _state->maxDepth = _options.maxDepth ? _options.maxDepth : static_cast<std::size_t>(-1);
+    _bytes = 0;
+    if (_options.timeout.count() > 0)
+        _deadline = std::chrono::steady_clock::now() + _options.timeout;
+    releaseArena();
+
+    if (_options.collectStats) {
+        _stats = ParseStats();
+        _state->handlerTicks = 0;
+        _state->callbacks = 0;
+        _state->sampledCallbacks = 0;
+        _state->countdown = 1;
+        _parseTicks = 0;
+        _startTime = _endTime = std::chrono::steady_clock::now();
+        _startTicks = _endTicks = ticks();
+        _startContentAllocations = _statsResource.allocations();
+    }
+
+    if (_context && static_cast<std::size_t>(xmlDictSize(_context->dict)) > kMaxDictionarySize) {
+        freeContext(_context);
+        _context = NULL;
+    }
+
+    if (_context) {
+        if (xmlCtxtResetPush(_context, NULL, 0, filename.c_str(), NULL) != 0)
+            return _state->stop(ParseStatus::Error);
+        *_context->sax = sax;
+        _context->userData = _state.get();
+    } else {
+        _context = xmlCreatePushParserCtxt(const_cast<xmlSAXHandler*>(&sax), _state.get(), NULL, 0, filename.c_str());
+        if (!_context)
+            return _state->stop(ParseStatus::Error);
+        if (_options.symbols)
+            useSymbolTable(_context, *_options.symbols);
+    }
+    _state->context = _context;
+    _state->sax = _context->sax;
+
+    _context->replaceEntities = 1;
+    return true;
+}
+
+bool Parser::begin(const std::string& filename, SAXHandler& handler) {
+    return begin(filename, saxTable(), &handler);
+}
+
+bool Parser::feed(const char* data, std::size_t length) {
+    if (!withinLimits(length))
+        return false;
+
+    int error = parseChunk(data, length, false);
+    if (error > 0)
+        return _state->stop(ParseStatus::Error);
+    return _state->status == ParseStatus::Ok;
+}
+
+int Parser::parseChunk(const char* data, std::size_t length, bool terminate) {
+    if (!_options.collectStats)
+        return xmlParseChunk(_context, data, (int)length, terminate);
+
+    std::uint64_t start = ticks();
+    int error = xmlParseChunk(_context, data, (int)length, terminate);
+    _endTicks = ticks();
+    _endTime = std::chrono::steady_clock::now();
+    _parseTicks += _endTicks - start;
+    _stats.bytes += length;
+    if (!terminate)
+        ++_stats.chunks;
+    return error;
+}
+
+bool Parser::withinLimits(std::size_t length) {
+    if (_options.cancel && _options.cancel->cancelled())
+        return _state->stop(ParseStatus::Cancelled);
+    if (_options.maxBytes && length > _options.maxBytes - std::min(_bytes, _options.maxBytes))
+        return _state->stop(ParseStatus::MaxBytes);
+    if (_options.timeout.count() > 0 && std::chrono::steady_clock::now() >= _deadline)
+        return _state->stop(ParseStatus::Timeout);
+    _bytes += length;
+    return true;
+}
+
+bool Parser::feedAll(const char* data, std::size_t length) {
+    // xmlParseChunk takes an int size, feed large regions in pieces
+    while (length > 0) {
+        std::size_t size = std::min(length, kMemoryChunkSize);
+        if (!feed(data, size))
+            return false;
+        data += size;
+        length -= size;
+    }
+    return true;
+}
+
+bool Parser::feedAll(ReadAhead& reader) {
+    const char* data;
+    std::size_t length;
+    bool result = true;
+    while (result && reader.next(data, length))
+        result = feedAll(data, length);
+    _readAheadStats = reader.stats();
+    return result;
+}
+
+bool Parser::finish() {
+    int error = parseChunk(NULL, 0, true); // EOF
+    _state->handler = 0;
+    if (error > 0)
+        return _state->stop(ParseStatus::Error);
+    return _state->status == ParseStatus::Ok;
+}
+
+bool Parser::done(bool result) {
+    if (!result && _state->status == ParseStatus::Ok)
+        _state->status = ParseStatus::Error;
+    return result;
+}
+
+ParseStatus Parser::status() const {
+    return _state->status;
+}
+
+ParseStats Parser::stats() const {
+    if (!_options.collectStats)
+        return ParseStats();
+
+    ParseStats stats = _stats;
+    stats.elements = _state->elements;
+    stats.contentAllocations = _statsResource.allocations() - _startContentAllocations;
+
+    double seconds = std::chrono::duration<double>(_endTime - _startTime).count();
+    if (_endTicks > _startTicks) {
+        double secondsPerTick = seconds / static_cast<double>(_endTicks - _startTicks);
+        stats.parseSeconds = static_cast<double>(_parseTicks) * secondsPerTick;
+        if (_state->sampledCallbacks > 0) {
+            double scale = static_cast<double>(_state->callbacks) / static_cast<double>(_state->sampledCallbacks);
+            stats.handlerSeconds = std::min(static_cast<double>(_state->handlerTicks) * scale * secondsPerTick, stats.parseSeconds);
+        }
+    }
+    return stats;
+}
+
+const xmlSAXHandler& Parser::saxTable() const {
+    if (_options.collectStats)
+        return SAXCallbacks<CollectStats>::table();
+    return SAXCallbacks<NoStats>::table();
+}
+
+bool Parser::parseStream(std::istream& is, const std::string& filename, const xmlSAXHandler& sax, void* handler) {
+    _state->status = ParseStatus::Ok;
+    if (_options.decompress && is) {
+        Compression compression = detectCompression(is);
+        if (compression != Compression::None)
+            return parseCompressed(compression, makeDecompressor(compression, is), filename, sax, handler);
+    }
+    if (_options.readAhead)
+        return parseReadAhead(is, filename, sax, handler);
+
+    ParseContext::Scope scope(_parseContext);
+    if (!is)
+        return false;
+    if (!begin(filename, sax, handler))
+        return false;
+
+    char memblock[kReadChunkSize];
+    while (is) {
+        is.read(memblock, kReadChunkSize);
+        if (!feed(memblock, static_cast<std::size_t>(is.gcount())))
+            return false;
+    }
+
+    return finish();
+}
+
+bool Parser::parseReadAhead(std::istream& is, const std::string& filename, const xmlSAXHandler& sax, void* handler) {
+    ParseContext::Scope scope(_parseContext);
+    _readAheadStats = ReadAheadStats();
+    if (!is)
+        return false;
+    if (!begin(filename, sax, handler))
+        return false;
+
+    ReadAhead reader(is, _options.readAheadBufferSize, _options.readAheadDepth);
+    return feedAll(reader) && finish();
+}
+
+bool Parser::parseCompressed(Compression compression, std::unique_ptr<InputSource> source, const std::string& filename, const xmlSAXHandler& sax, void* handler) {
+    ParseContext::Scope scope(_parseContext);
+    _readAheadStats = ReadAheadStats();
+    if (!source) {
+        _state->handler = handler;
+        reportError(sax, *_state, filename, compression == Compression::Zstd ?
+                    "Document is zstd compressed, and lxml was built without zstd support\n" :
+                    "Document is gzip compressed, and lxml was built without zlib support\n");
+        _state->handler = 0;
+        _state->status = ParseStatus::Unsupported;
+        return false;
+    }
+    if (!begin(filename, sax, handler))
+        return false;
+
+    // Decompress on the reader thread straight into the buffers fed to libxml2
+    ReadAhead reader(*source, _options.readAheadBufferSize, _options.readAheadDepth);
+    bool result = feedAll(reader);
+    if (result && source->failed()) {
+        reportError(sax, *_state, filename, "Compressed data is corrupt or truncated\n");
+        return _state->stop(ParseStatus::Error);
+    }
+    if (!result)
+        return false;
+    return finish();
+}
+
+bool Parser::parseMemory(const char* data, std::size_t length, const std::string& filename, const xmlSAXHandler& sax, void* handler) {
+    _state->status = ParseStatus::Ok;
+    if (_options.decompress) {
+        Compression compression = detectCompression(data, length);
+        if (compression != Compression::None)
+            return parseCompressed(compression, makeDecompressor(compression, data, length), filename, sax, handler);
+    }
+
+    ParseContext::Scope scope(_parseContext);
+    if (!begin(filename, sax, handler))
+        return false;
+    if (!feedAll(data, length))
+        return false;
+    return finish();
+}
+
+bool Parser::parseMapped(const std::string& path, const xmlSAXHandler& sax, void* handler) {
+    _state->status = ParseStatus::Ok;
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    return parseMemory(file.data(), file.size(), path, sax, handler);
+}
+
+bool Parser::parse(std::istream& is, const std::string& filename, RecursiveHandler& handler) {
+    _rootHandler.reset(&handler);
+    return parse(is, filename, _rootHandler);
+}
+
+bool Parser::parse(std::istream& is, const std::string& filename, SAXHandler& handler) {
+    return done(parseStream(is, filename, saxTable(), &handler));
+}
+
+bool Parser::parse(const char* data, std::size_t length, const std::string& filename, RecursiveHandler& handler) {
+    _rootHandler.reset(&handler);
+    return parse(data, length, filename, _rootHandler);
+}
+
+bool Parser::parse(const char* data, std::size_t length, const std::string& filename, SAXHandler& handler) {
+    return done(parseMemory(data, length, filename, saxTable(), &handler));
+}
+
+bool Parser::parseFile(const std::string& path, RecursiveHandler& handler) {
+    _rootHandler.reset(&handler);
+    return parseFile(path, _rootHandler);
+}
+
+bool Parser::parseFile(const std::string& path, SAXHandler& handler) {
+    return done(parseMapped(path, saxTable(), &handler));
+}
+
+} // namespace lxml
@@ -0,0 +1,232 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "Decompressor.h"
+#include "ParseContext.h"
+#include "ParseOptions.h"
+#include "ParseStats.h"
+#include "ParseStatus.h"
+#include "ReadAhead.h"
+#include "RecursiveHandler.h"
+#include "RootRecursiveHandler.h"
+#include "SAXHandler.h"
+#include "StaticSAXHandler.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <libxml/parser.h>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+
+namespace lxml {
+
+struct ParseState;
+
+/**
+ Parser is a long-lived XML parser. It keeps its libxml2 context, name
+ dictionary and recursive handler stacks between documents, which makes
+ parsing many small documents much cheaper than calling `parse` for each
+ of them.
+ 
+ A Parser is not thread safe. Use one per thread, for instance through
+ ParserPool.
+ */
+class Parser {
+public:
+    Parser();
+    explicit Parser(const ParseOptions& options);
+    ~Parser();
+    
+    Parser(const Parser&) = delete;
+    Parser& operator=(const Parser&) = delete;
+    
+    const ParseOptions& options() const {
+        return _options;
+    }
+    
+    /**
+     Release the arena used with `ParseOptions::useArena` now instead of
+     when the next document starts.
+     */
+    void releaseArena();
+    
+    /**
+     Metrics of the last stream parsed with `ParseOptions::readAhead`, or of
+     the last compressed document.
+     */
+    const ReadAheadStats& readAheadStats() const {
+        return _readAheadStats;
+    }
+    
+    /**
+     How the last parse ended. The parse functions return `true` only when
+     this is `ParseStatus::Ok`; this tells a failure apart from a stop
+     requested by a handler, a cancellation or an exhausted budget.
+     */
+    ParseStatus status() const;
+    
+    /**
+     Statistics of the last parse when `ParseOptions::collectStats` is set.
+     Callback times use the CPU's time stamp counter where available and
+     include the handler's own work as well as lxml's dispatch.
+     */
+    ParseStats stats() const;
+    
+    /**
+     Parse an XML stream delivering SAX events to a handler.
+     
+     @return `true` if parsing is successful, `false` if there is an error
+             parsing.
+     */
+    bool parse(std::istream& is, const std::string& filename, SAXHandler& handler);
+    
+    /**
+     Parse an XML stream delivering SAX events recursively to handlers.
+     
+     @return `true` if parsing is successful, `false` if there is an error
+             parsing.
+     */
+    bool parse(std::istream& is, const std::string& filename, RecursiveHandler& handler);
+    
+    /**
+     Parse an XML document in memory delivering SAX events to a handler.
+     
+     @return `true` if parsing is successful, `false` if there is an error
+             parsing.
+     */
+    bool parse(const char* data, std::size_t length, const std::string& filename, SAXHandler& handler);
+    
+    /**
+     Parse an XML document in memory delivering SAX events recursively to
+     handlers.
+     
+     @return `true` if parsing is successful, `false` if there is an error
+             parsing.
+     */
+    bool parse(const char* data, std::size_t length, const std::string& filename, RecursiveHandler& handler);
+    
+    /**
+     Parse a memory mapped XML file delivering SAX events to a handler.
+     
+     @return `true` if parsing is successful, `false` if the file can't be
+             opened or there is an error parsing.
+     */
+    bool parseFile(const std::string& path, SAXHandler& handler);
+    
+    /**
+     Parse a memory mapped XML file delivering SAX events recursively to
+     handlers.
+     
+     @return `true` if parsing is successful, `false` if the file can't be
+             opened or there is an error parsing.
+     */
+    bool parseFile(const std::string& path, RecursiveHandler& handler);
+    
+    /**
+     Parse an XML stream delivering SAX events to a handler with statically
+     dispatched callbacks. See isStaticHandler for what a handler looks
+     like.
+     */
+    template <typename Handler, typename = std::enable_if_t<isStaticHandler<Handler>>>
+    bool parse(std::istream& is, const std::string& filename, Handler& handler) {
+        return done(parseStream(is, filename, staticTable<Handler>(), &handler));
+    }
+    
+    /**
+     Parse an XML document in memory delivering SAX events to a handler
+     with statically dispatched callbacks.
+     */
+    template <typename Handler, typename = std::enable_if_t<isStaticHandler<Handler>>>
+    bool parse(const char* data, std::size_t length, const std::string& filename, Handler& handler) {
+        return done(parseMemory(data, length, filename, staticTable<Handler>(), &handler));
+    }
+    
+    /**
+     Parse a memory mapped XML file delivering SAX events to a handler with
+     statically dispatched callbacks.
+     */
+    template <typename Handler, typename = std::enable_if_t<isStaticHandler<Handler>>>
+    bool parseFile(const std::string& path, Handler& handler) {
+        return done(parseMapped(path, staticTable<Handler>(), &handler));
+    }
+    
+private:
+    friend class PushParser;
+    friend class XmlReader;
+    
+    template <typename Handler>
+    const xmlSAXHandler& staticTable() const {
+        if (_options.collectStats)
+            return StaticSAXHandler<Handler, CollectStats>::table();
+        if (!HasStartElement<Handler>::value && (_options.maxElements || _options.maxDepth))
+            return StaticSAXHandler<Handler, CountElements>::table();
+        return StaticSAXHandler<Handler>::table();
+    }
+    const xmlSAXHandler& saxTable() const;
+    
+    bool parseStream(std::istream& is, const std::string& filename, const xmlSAXHandler& sax, void* handler);
+    bool parseReadAhead(std::istream& is, const std::string& filename, const xmlSAXHandler& sax, void* handler);
+    bool parseCompressed(Compression compression, std::unique_ptr<InputSource> source, const std::string& filename, const xmlSAXHandler& sax, void* handler);
+    bool parseMemory(const char* data, std::size_t length, const std::string& filename, const xmlSAXHandler& sax, void* handler);
+    bool parseMapped(const std::string& path, const xmlSAXHandler& sax, void* handler);
+    
+    bool begin(const std::string& filename, const xmlSAXHandler& sax, void* handler);
+    bool begin(const std::string& filename, SAXHandler& handler);
+    bool feed(const char* data, std::size_t length);
+    bool feedAll(const char* data, std::size_t length);
+    bool feedAll(ReadAhead& reader);
+    bool finish();
+    int parseChunk(const char* data, std::size_t length, bool terminate);
+    bool withinLimits(std::size_t length);
+    bool done(bool result);
+    
+private:
+    ParseOptions _options;
+    std::unique_ptr<ParseState> _state;
+    xmlParserCtxtPtr _context;
+    ReadAheadStats _readAheadStats;
+    
+    /// Bytes handed to libxml2 and when to time out, for the budgets
+    std::size_t _bytes;
+    std::chrono::steady_clock::time_point _deadline;
+    
+    /// Statistics, with times in `ticks()` calibrated against the clock
+    ParseStats _stats;
+    std::uint64_t _parseTicks;
+    std::uint64_t _startTicks;
+    std::uint64_t _endTicks;
+    std::chrono::steady_clock::time_point _startTime;
+    std::chrono::steady_clock::time_point _endTime;
+    std::size_t _startContentAllocations;
+    
+    // The root handler may allocate from the arena, keep it last
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> _arena;
+    ParseContext _parseContext;
+    CountingResource _statsResource;
+    RootRecursiveHandler _rootHandler;
+};
+
+} // namespace lxml
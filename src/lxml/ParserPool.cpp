@@ -0,0 +1,70 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "ParserPool.h"
+#include <atomic>
+#include <libxml/parser.h>
+
+namespace lxml {
+
+static std::atomic<std::uint64_t> __next_pool_id(1);
+
+/**
+ The last parser handed out on this thread. Pool ids are never reused, so
+ an entry for a destroyed pool never matches.
+ */
+struct LocalParser {
+    std::uint64_t poolId;
+    Parser* parser;
+};
+
+static thread_local LocalParser __local_parser = { 0, 0 };
+
+ParserPool::ParserPool(const ParseOptions& options) : _id(__next_pool_id++), _options(options) {
+    // libxml2 must be initialized before threads use it
+    xmlInitParser();
+
+    if (!_options.symbols) {
+        _ownedSymbols.reset(new SymbolTable);
+        _options.symbols = _ownedSymbols.get();
+    }
+}
+
+Parser& ParserPool::local() {
+    if (__local_parser.poolId == _id)
+        return *__local_parser.parser;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unique_ptr<Parser>& parser = _parsers[std::this_thread::get_id()];
+    if (!parser)
+        parser.reset(new Parser(_options));
+
+    __local_parser.poolId = _id;
+    __local_parser.parser = parser.get();
+    return *parser;
+}
+
+std::size_t ParserPool::size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _parsers.size();
+}
+
+} // namespace lxml
@@ -0,0 +1,82 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "Parser.h"
+#include "SymbolTable.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace lxml {
+
+/**
+ ParserPool hands out one Parser per thread, so that worker threads can
+ each reuse their own parser context without locking.
+ 
+ All parsers in a pool share a read-only SymbolTable, either the one in the
+ options or one owned by the pool. Only names registered in that table are
+ interned: they stay valid across documents and threads and compare by
+ pointer. Other names come from each parser's own dictionary. They compare
+ by content and are only valid until the parser's next document. To test
+ against your own symbols, register them in a table and pass it in the
+ options.
+ 
+ Parsers are kept until the pool is destroyed. The pool must outlive any
+ use of the parsers it returns.
+ */
+class ParserPool {
+public:
+    explicit ParserPool(const ParseOptions& options = ParseOptions());
+    
+    ParserPool(const ParserPool&) = delete;
+    ParserPool& operator=(const ParserPool&) = delete;
+    
+    /**
+     The symbol table shared by all parsers in the pool.
+     */
+    const SymbolTable& symbols() const {
+        return *_options.symbols;
+    }
+    
+    /**
+     Get the calling thread's parser, creating it on first use.
+     */
+    Parser& local();
+    
+    /**
+     The number of parsers created so far.
+     */
+    std::size_t size() const;
+    
+private:
+    const std::uint64_t _id;
+    ParseOptions _options;
+    std::unique_ptr<SymbolTable> _ownedSymbols;
+    
+    mutable std::mutex _mutex;
+    std::map<std::thread::id, std::unique_ptr<Parser>> _parsers;
+};
+
+} // namespace lxml
@@ -0,0 +1,267 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "PathSelector.h"
+#include "ParseContext.h"
+
+namespace lxml {
+
+static bool isNameChar(char c) {
+    switch (c) {
+        case '/': case '[': case ']': case '@': case '=': case '*':
+        case '\'': case '"': case ':':
+        case ' ': case '\t': case '\r': case '\n':
+            return false;
+        default:
+            return true;
+    }
+}
+
+/**
+ Read a name or `*` at the start of `source`. A wildcard yields an empty
+ name.
+ */
+static bool readName(std::string_view& source, std::string& name, bool wildcard) {
+    if (wildcard && !source.empty() && source.front() == '*') {
+        name.clear();
+        source.remove_prefix(1);
+        return true;
+    }
+    
+    std::size_t length = 0;
+    while (length < source.size() && isNameChar(source[length]))
+        ++length;
+    if (length == 0)
+        return false;
+    
+    name.assign(source.data(), length);
+    source.remove_prefix(length);
+    return true;
+}
+
+static bool readPredicate(std::string_view& source, std::string& name, std::string& value, bool& hasValue) {
+    // [@name] or [@name='value']
+    source.remove_prefix(1);
+    if (source.empty() || source.front() != '@')
+        return false;
+    source.remove_prefix(1);
+    if (!readName(source, name, false))
+        return false;
+    
+    hasValue = !source.empty() && source.front() == '=';
+    if (hasValue) {
+        source.remove_prefix(1);
+        if (source.empty() || (source.front() != '\'' && source.front() != '"'))
+            return false;
+        std::size_t end = source.find(source.front(), 1);
+        if (end == std::string_view::npos)
+            return false;
+        value.assign(source.data() + 1, end - 1);
+        source.remove_prefix(end + 1);
+    }
+    
+    if (source.empty() || source.front() != ']')
+        return false;
+    source.remove_prefix(1);
+    return true;
+}
+
+static bool equals(const std::string& name, const char* string) {
+    return string && name.compare(string) == 0;
+}
+
+PathSelector::PathSelector() : _stamp() {
+}
+
+std::size_t PathSelector::add(std::string_view source, Callback callback) {
+    Path path;
+    if (!compile(source, path))
+        return npos;
+    
+    path.firstState = static_cast<std::uint32_t>(_states.size());
+    path.callback = std::move(callback);
+    for (std::size_t i = 0; i < path.steps.size(); ++i)
+        _states.push_back(State{static_cast<std::uint32_t>(_paths.size()), static_cast<std::uint32_t>(i)});
+    _stamps.resize(_states.size());
+    
+    _paths.push_back(std::move(path));
+    return _paths.size() - 1;
+}
+
+bool PathSelector::compile(std::string_view source, Path& path) {
+    path.attribute = false;
+    if (source.empty() || source.front() != '/')
+        return false;
+    
+    while (!source.empty()) {
+        if (source.front() != '/')
+            return false;
+        source.remove_prefix(1);
+        
+        Axis axis = Axis::Child;
+        if (!source.empty() && source.front() == '/') {
+            axis = Axis::Descendant;
+            source.remove_prefix(1);
+        }
+        
+        if (!source.empty() && source.front() == '@') {
+            // The document has no attributes, `//@name` selects them on any element
+            if (path.steps.empty() && axis == Axis::Child)
+                return false;
+            if (axis == Axis::Descendant)
+                path.steps.push_back(Step{Axis::Descendant, std::string(), {}});
+            
+            source.remove_prefix(1);
+            path.attribute = true;
+            return readName(source, path.attributeName, true) && source.empty();
+        }
+        
+        Step step{axis, std::string(), {}};
+        if (!readName(source, step.name, true))
+            return false;
+        while (!source.empty() && source.front() == '[') {
+            Predicate predicate;
+            if (!readPredicate(source, predicate.name, predicate.value, predicate.hasValue))
+                return false;
+            step.predicates.push_back(std::move(predicate));
+        }
+        path.steps.push_back(std::move(step));
+    }
+    
+    return !path.steps.empty();
+}
+
+bool PathSelector::matches(const Step& step, const QName& qname, const AttributeView& attributes) {
+    if (!step.name.empty() && !equals(step.name, qname.localName()))
+        return false;
+    
+    for (const Predicate& predicate : step.predicates) {
+        bool found = false;
+        for (Attribute attribute : attributes) {
+            if (equals(predicate.name, attribute.localName()) && (!predicate.hasValue || attribute.value() == predicate.value)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            return false;
+    }
+    return true;
+}
+
+void PathSelector::pushState(std::uint32_t state) {
+    if (_stamps[state] == _stamp)
+        return;
+    _stamps[state] = _stamp;
+    _active.push_back(state);
+}
+
+void PathSelector::matched(std::size_t index, const QName& qname, const AttributeView& attributes) {
+    const Path& path = _paths[index];
+    if (!path.attribute) {
+        _captures.push_back(Capture{index, _levels.size() - 1, _text.size()});
+        return;
+    }
+    
+    for (Attribute attribute : attributes) {
+        if (path.attributeName.empty() || equals(path.attributeName, attribute.localName()))
+            path.callback(PathMatch{index, attribute.qname(), attribute.value()});
+    }
+}
+
+void PathSelector::startDocument() {
+    _active.clear();
+    _levels.clear();
+    _captures.clear();
+    _text.clear();
+    
+    // The document node is waiting for the first step of every path
+    ++_stamp;
+    _levels.push_back(0);
+    for (const Path& path : _paths)
+        pushState(path.firstState);
+}
+
+void PathSelector::endDocument() {
+}
+
+void PathSelector::startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+    std::size_t begin = _levels.back();
+    std::size_t end = _active.size();
+    _levels.push_back(end);
+    ++_stamp;
+    
+    for (std::size_t i = begin; i < end; ++i) {
+        std::uint32_t state = _active[i];
+        const Path& path = _paths[_states[state].path];
+        std::uint32_t index = _states[state].step;
+        const Step& step = path.steps[index];
+        
+        // A descendant step keeps waiting in deeper elements
+        if (step.axis == Axis::Descendant)
+            pushState(state);
+        
+        if (!matches(step, qname, attributes))
+            continue;
+        if (index + 1 < path.steps.size())
+            pushState(state + 1);
+        else
+            matched(_states[state].path, qname, attributes);
+    }
+    
+    if (_active.size() == end && _captures.empty()) {
+        // Nothing below this element can match
+        if (ParseContext* context = ParseContext::current())
+            context->skipSubtree();
+    }
+}
+
+void PathSelector::endElement(const QName& qname) {
+    std::size_t depth = _levels.size() - 1;
+    std::size_t first = _captures.size();
+    while (first > 0 && _captures[first - 1].depth == depth)
+        --first;
+    
+    for (std::size_t i = first; i < _captures.size(); ++i) {
+        const Capture& capture = _captures[i];
+        std::string_view value(_text.data() + capture.start, _text.size() - capture.start);
+        _paths[capture.path].callback(PathMatch{capture.path, qname, value});
+    }
+    _captures.resize(first);
+    
+    // Enclosing captures include this element's text
+    if (_captures.empty())
+        _text.clear();
+    
+    _active.resize(_levels.back());
+    _levels.pop_back();
+}
+
+void PathSelector::characters(const char* chars, std::size_t length) {
+    if (!_captures.empty())
+        _text.append(chars, length);
+}
+
+void PathSelector::error(const xmlError& error) {
+    
+}
+
+} // namespace lxml
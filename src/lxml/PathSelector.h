@@ -0,0 +1,169 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "SAXHandler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lxml {
+
+/**
+ A value selected by a PathSelector. The name and value are only valid for
+ the duration of the callback.
+ */
+struct PathMatch {
+    /// The index of the path that matched, in the order paths were added
+    std::size_t path;
+    
+    /// The name of the matching element or attribute
+    QName name;
+    
+    /// The text of the element, including its descendants, or the value of
+    /// the attribute
+    std::string_view value;
+};
+
+/**
+ PathSelector is a SAXHandler that streams the values of a set of simple
+ location paths out of a document, for instance
+ 
+     /feed/entry/id
+     //price[@currency]
+     /feed/entry/link[@rel='alternate']/@href
+ 
+ A path is a sequence of steps separated by `/` (child) or `//`
+ (descendant). Each step is an element name or `*`, optionally followed by
+ attribute predicates `[@name]` or `[@name='value']`. A path may end with
+ an attribute step `@name` or `@*`. Names are compared with local names,
+ namespace prefixes are not supported.
+ 
+ All paths run together as one automaton that keeps the set of pending
+ steps for every open element, so memory is bounded by the document depth
+ and the number of paths. Subtrees where no path can match are skipped by
+ the parser.
+ */
+class PathSelector : public SAXHandler {
+public:
+    typedef std::function<void(const PathMatch& match)> Callback;
+    
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    
+public:
+    PathSelector();
+    
+    /**
+     Compile a path and register the callback to invoke for each match.
+     Element matches are reported when the element ends, attribute matches
+     when the element starts.
+     
+     @return The index of the path or `npos` if the path is malformed.
+     */
+    std::size_t add(std::string_view path, Callback callback);
+    
+    std::size_t size() const {
+        return _paths.size();
+    }
+    
+    virtual void startDocument();
+    virtual void endDocument();
+    
+    virtual void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes);
+    virtual void endElement(const QName& qname);
+    
+    virtual void characters(const char* chars, std::size_t length);
+    virtual void error(const xmlError& error);
+    
+private:
+    enum class Axis {
+        Child,
+        Descendant
+    };
+    
+    struct Predicate {
+        std::string name;
+        std::string value;
+        bool hasValue;
+    };
+    
+    struct Step {
+        Axis axis;
+        
+        /// The element name, empty for `*`
+        std::string name;
+        std::vector<Predicate> predicates;
+    };
+    
+    struct Path {
+        std::vector<Step> steps;
+        
+        /// Whether the path selects an attribute of the last step
+        bool attribute;
+        
+        /// The attribute name, empty for `@*`
+        std::string attributeName;
+        
+        /// The automaton state of the first step, the others follow it
+        std::uint32_t firstState;
+        Callback callback;
+    };
+    
+    /// The automaton state of a path step
+    struct State {
+        std::uint32_t path;
+        std::uint32_t step;
+    };
+    
+    /// An element whose text is being collected for a path
+    struct Capture {
+        std::size_t path;
+        std::size_t depth;
+        std::size_t start;
+    };
+    
+    static bool compile(std::string_view source, Path& path);
+    static bool matches(const Step& step, const QName& qname, const AttributeView& attributes);
+    
+    void pushState(std::uint32_t state);
+    void matched(std::size_t path, const QName& qname, const AttributeView& attributes);
+    
+private:
+    std::vector<Path> _paths;
+    std::vector<State> _states;
+    
+    /// Pending states of all open elements and where each element's start
+    std::vector<std::uint32_t> _active;
+    std::vector<std::size_t> _levels;
+    
+    /// Avoids adding a state twice to the same element
+    std::vector<std::uint64_t> _stamps;
+    std::uint64_t _stamp;
+    
+    std::vector<Capture> _captures;
+    std::string _text;
+};
+
+} // namespace lxml
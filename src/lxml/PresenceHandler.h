@@ -29,7 +29,11 @@ namespace lxml {
  */
 class PresenceHandler : public BaseRecursiveHandler<bool> {
 public:
-    void startElement(const QName& qname, const AttributeMap& attributes) {
+    ContentPolicy contentPolicy() const {
+        return ContentPolicy::Ignore;
+    }
+    
+    void startElement(const QName& qname, const AttributeView& attributes) {
         _result = true;
     }
 };
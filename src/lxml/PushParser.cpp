@@ -0,0 +1,107 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "PushParser.h"
+
+namespace lxml {
+
+PushParser::PushParser() : _recursive(), _active(), _failed() {
+}
+
+PushParser::PushParser(const ParseOptions& options) : _parser(options), _recursive(), _active(), _failed() {
+}
+
+bool PushParser::begin(const std::string& filename, SAXHandler& handler) {
+    _recursive = false;
+    _counter.handler = &handler;
+    _counter.depth = 0;
+    _counter.records = 0;
+    return start(filename, _counter);
+}
+
+bool PushParser::begin(const std::string& filename, RecursiveHandler& handler) {
+    // The root handler counts records itself
+    _recursive = true;
+    _parser._rootHandler.reset(&handler);
+    return start(filename, _parser._rootHandler);
+}
+
+bool PushParser::start(const std::string& filename, SAXHandler& handler) {
+    ParseContext::Scope scope(_parser._parseContext);
+    _active = _parser.begin(filename, handler);
+    _failed = !_active;
+    return _active;
+}
+
+bool PushParser::feed(const char* data, std::size_t length) {
+    if (!_active || _failed)
+        return false;
+    
+    ParseContext::Scope scope(_parser._parseContext);
+    _failed = !_parser.feedAll(data, length);
+    return !_failed;
+}
+
+bool PushParser::finish() {
+    if (!_active)
+        return false;
+    
+    ParseContext::Scope scope(_parser._parseContext);
+    _active = false;
+    if (!_parser.finish())
+        _failed = true;
+    return !_failed;
+}
+
+std::size_t PushParser::recordCount() const {
+    if (_recursive)
+        return _parser._rootHandler.recordCount();
+    return _counter.records;
+}
+
+void PushParser::RecordCounter::startDocument() {
+    handler->startDocument();
+}
+
+void PushParser::RecordCounter::endDocument() {
+    handler->endDocument();
+}
+
+void PushParser::RecordCounter::startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+    ++depth;
+    handler->startElement(qname, namespaces, attributes);
+}
+
+void PushParser::RecordCounter::endElement(const QName& qname) {
+    handler->endElement(qname);
+    if (--depth == 1)
+        ++records;
+}
+
+void PushParser::RecordCounter::characters(const char* chars, std::size_t length) {
+    handler->characters(chars, length);
+}
+
+void PushParser::RecordCounter::error(const xmlError& error) {
+    handler->error(error);
+}
+
+} // namespace lxml
@@ -0,0 +1,153 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "Parser.h"
+
+#include <cstddef>
+#include <string>
+
+namespace lxml {
+
+/**
+ PushParser parses a document that arrives in fragments, for instance from
+ a non-blocking socket. Start a document with `begin`, hand it every
+ fragment as it arrives with `feed` and call `finish` after the last one.
+ All state, including the recursive handler stacks, is kept between calls
+ and no call ever waits for more input.
+ 
+ Fragments are passed to libxml2 as they are. libxml2 appends each one to
+ its input buffer, parses as far as it can and discards consumed input when
+ it compacts the buffer later, so the buffer can hold more than the
+ incomplete part of the document.
+ 
+ `recordCount()` counts the children of the document element that have
+ ended, such as the `<record>` elements of `<feed><record/>...</feed>`. An
+ event loop can compare it before and after `feed` to consume results as
+ soon as they are complete, and stop reading while results are pending.
+ 
+ Read-ahead and decompression options don't apply to pushed input.
+ */
+class PushParser {
+public:
+    PushParser();
+    explicit PushParser(const ParseOptions& options);
+    
+    PushParser(const PushParser&) = delete;
+    PushParser& operator=(const PushParser&) = delete;
+    
+    /**
+     Start a document delivering SAX events to a handler. A document that
+     wasn't finished is discarded.
+     
+     @return `false` if the parser context can't be created.
+     */
+    bool begin(const std::string& filename, SAXHandler& handler);
+    
+    /**
+     Start a document delivering SAX events recursively to handlers.
+     */
+    bool begin(const std::string& filename, RecursiveHandler& handler);
+    
+    /**
+     Parse the next fragment of the document. Events for everything that
+     can be parsed so far are delivered before returning.
+     
+     @return `false` if there is an error parsing or no document was
+             started. Once a document has failed every call fails until the
+             next `begin`.
+     */
+    bool feed(const char* data, std::size_t length);
+    
+    /**
+     End the document.
+     
+     @return `true` if the whole document was parsed successfully, `false`
+             if there was an error or the document is incomplete.
+     */
+    bool finish();
+    
+    /**
+     Whether a document was started and not finished yet.
+     */
+    bool active() const {
+        return _active;
+    }
+    
+    /**
+     Whether the current or last document had an error or was stopped. See
+     `status()` for which.
+     */
+    bool failed() const {
+        return _failed;
+    }
+    
+    /**
+     How the current or last document ended, `ParseStatus::Ok` while it is
+     going well. Tells a handler's `ParseContext::stop()` apart from errors
+     and budgets.
+     */
+    ParseStatus status() const {
+        return _parser.status();
+    }
+    
+    /**
+     The number of children of the document element that have ended since
+     `begin`.
+     */
+    std::size_t recordCount() const;
+    
+    Parser& parser() {
+        return _parser;
+    }
+    
+private:
+    /**
+     Forwards events to a SAX handler and counts records.
+     */
+    class RecordCounter : public SAXHandler {
+    public:
+        RecordCounter() : handler(), depth(), records() {}
+        
+        void startDocument();
+        void endDocument();
+        void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes);
+        void endElement(const QName& qname);
+        void characters(const char* chars, std::size_t length);
+        void error(const xmlError& error);
+        
+    public:
+        SAXHandler* handler;
+        std::size_t depth;
+        std::size_t records;
+    };
+    
+    bool start(const std::string& filename, SAXHandler& handler);
+    
+private:
+    Parser _parser;
+    RecordCounter _counter;
+    bool _recursive;
+    bool _active;
+    bool _failed;
+};
+
+} // namespace lxml
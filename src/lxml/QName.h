@@ -18,7 +18,11 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 // DEALINGS IN THE SOFTWARE.
 
+
 #pragma once
+#include <cstddef>
+#include <cstring>
+#include <functional>
 #include <string>
 
 namespace lxml {
@@ -26,14 +30,35 @@ namespace lxml {
 /**
  QName represents an XML qualified name. It consists of a local name, a
  prefix and a namespace URI.
+ 
+ A QName can be interned, meaning its strings come from a SymbolTable.
+ Two interned QNames are compared by pointer instead of by content. Names
+ delivered by the parser are interned when parsing with a SymbolTable in
+ which they are registered, and SymbolTable::intern creates interned names
+ to test against.
  */
 class QName {
 public:
-    QName() = default;
+    QName()
+    : _localName(), _prefix(), _namespaceURI(), _hash(), _interned() {}
     QName(const char* localName)
-    : _localName(localName), _prefix(), _namespaceURI() {}
+    : _localName(localName), _prefix(), _namespaceURI(), _hash(), _interned() {}
     QName(const char* localName, const char* prefix, const char* nsURI)
-    : _localName(localName), _prefix(prefix), _namespaceURI(nsURI) {}
+    : _localName(localName), _prefix(prefix), _namespaceURI(nsURI), _hash(), _interned() {}
+    
+    /**
+     Create an interned QName. All strings must come from the same
+     dictionary (or a sub-dictionary of it) as the names it will be
+     compared to.
+     
+     @param hash A precomputed hash, or `0` to compute it on demand.
+     */
+    static QName interned(const char* localName, const char* prefix, const char* nsURI, std::size_t hash = 0) {
+        QName qname(localName, prefix, nsURI);
+        qname._hash = hash;
+        qname._interned = true;
+        return qname;
+    }
     
     const char* localName() const {
         return _localName;
@@ -44,14 +69,33 @@ public:
     const char* namespaceURI() const {
         return _namespaceURI;
     }
+    bool isInterned() const {
+        return _interned;
+    }
+    
+    /**
+     A hash of the local name and namespace URI, consistent with
+     `operator==`. Names created by SymbolTable have it precomputed.
+     */
+    std::size_t hash() const {
+        return _hash ? _hash : computeHash(_localName, _namespaceURI);
+    }
     
     bool operator==(const QName& qname) const {
+        if (_localName == qname._localName && _prefix == qname._prefix && _namespaceURI == qname._namespaceURI)
+            return true;
+        if (_interned && qname._interned)
+            return false;
         return
             compare(_localName, qname._localName) == 0 &&
             compare(_prefix, qname._prefix) == 0 &&
             compare(_namespaceURI, qname._namespaceURI) == 0;
     }
     
+    bool operator!=(const QName& qname) const {
+        return !(*this == qname);
+    }
+    
     bool operator<(const QName& qname) const {
         int o = compare(_localName, qname._localName);
         if (o == 0) o = compare(_prefix, qname._prefix);
@@ -66,10 +110,34 @@ public:
         return 0;
     }
     
+    static std::size_t computeHash(const char* localName, const char* nsURI) {
+        // FNV-1a over both strings, never 0 so that 0 can mean "not computed"
+        std::size_t hash = 14695981039346656037ull;
+        for (const char* c = localName; c && *c; ++c)
+            hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+        hash = (hash ^ 0xff) * 1099511628211ull;
+        for (const char* c = nsURI; c && *c; ++c)
+            hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+        return hash ? hash : 1;
+    }
+    
 private:
     const char* _localName;
     const char* _prefix;
     const char* _namespaceURI;
+    std::size_t _hash;
+    bool _interned;
 };
 
 } // namespace lxml
+
+namespace std {
+
+template <>
+struct hash<lxml::QName> {
+    std::size_t operator()(const lxml::QName& qname) const {
+        return qname.hash();
+    }
+};
+
+} // namespace std
@@ -0,0 +1,165 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "ReadAhead.h"
+#include "Wait.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace lxml {
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+namespace {
+
+class StreamSource : public InputSource {
+public:
+    explicit StreamSource(std::istream& is) : _is(is) {}
+
+    std::size_t read(char* buffer, std::size_t size) {
+        if (!_is)
+            return 0;
+        _is.read(buffer, static_cast<std::streamsize>(size));
+        return static_cast<std::size_t>(_is.gcount());
+    }
+
+private:
+    std::istream& _is;
+};
+
+} // namespace
+
+ReadAhead::ReadAhead(std::istream& is, std::size_t bufferSize, std::size_t depth)
+: _streamSource(new StreamSource(is)), _source(*_streamSource), _bufferSize(std::max<std::size_t>(bufferSize, 1)),
+  _tail(), _head(), _free(), _holding(), _done(), _stopping() {
+    start(depth);
+}
+
+ReadAhead::ReadAhead(InputSource& source, std::size_t bufferSize, std::size_t depth)
+: _source(source), _bufferSize(std::max<std::size_t>(bufferSize, 1)),
+  _tail(), _head(), _free(), _holding(), _done(), _stopping() {
+    start(depth);
+}
+
+void ReadAhead::start(std::size_t depth) {
+    _buffers.resize(std::max<std::size_t>(depth, 2));
+    for (Buffer& buffer : _buffers) {
+        buffer.data.reset(new char[_bufferSize]);
+        buffer.length = 0;
+    }
+    _thread = std::thread(&ReadAhead::read, this);
+}
+
+ReadAhead::~ReadAhead() {
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+        done = _done;
+    }
+    _released.notify_one();
+
+    // The reader may be blocked in the source rather than waiting for a buffer
+    if (!done)
+        _source.cancel();
+    _thread.join();
+}
+
+void ReadAhead::read() {
+    while (true) {
+        Buffer* buffer;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (!_stopping && _tail - _free == _buffers.size()) {
+                Clock::time_point start = Clock::now();
+                waitUntil(_released, lock, [this]() { return _stopping || _tail - _free < _buffers.size(); });
+                _stats.readerStalls += 1;
+                _stats.readerStallSeconds += secondsSince(start);
+            }
+            if (_stopping)
+                break;
+            buffer = &_buffers[_tail % _buffers.size()];
+        }
+
+        // Only the reader touches the buffer between _free and _tail. Sources
+        // may return short reads, fill the buffer to keep feeds large.
+        std::size_t length = 0;
+        std::size_t count;
+        do {
+            count = _source.read(buffer->data.get() + length, _bufferSize - length);
+            length += count;
+        } while (count > 0 && length < _bufferSize);
+        buffer->length = length;
+        bool end = count == 0;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (buffer->length > 0) {
+            _tail += 1;
+            _stats.buffers += 1;
+            _stats.bytes += buffer->length;
+        }
+        _done = end;
+        _filled.notify_one();
+        if (end)
+            break;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _done = true;
+    _filled.notify_one();
+}
+
+bool ReadAhead::next(const char*& data, std::size_t& length) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_holding) {
+        _free += 1;
+        _holding = false;
+        _released.notify_one();
+    }
+
+    if (_head == _tail && !_done) {
+        Clock::time_point start = Clock::now();
+        waitUntil(_filled, lock, [this]() { return _head < _tail || _done; });
+        _stats.parserStalls += 1;
+        _stats.parserStallSeconds += secondsSince(start);
+    }
+    if (_head == _tail)
+        return false;
+
+    const Buffer& buffer = _buffers[_head % _buffers.size()];
+    data = buffer.data.get();
+    length = buffer.length;
+    _head += 1;
+    _holding = true;
+    return true;
+}
+
+ReadAheadStats ReadAhead::stats() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+} // namespace lxml
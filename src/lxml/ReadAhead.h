@@ -0,0 +1,162 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lxml {
+
+/**
+ InputSource produces the bytes of a document for ReadAhead.
+ */
+class InputSource {
+public:
+    virtual ~InputSource() {}
+    
+    /**
+     Fill a buffer.
+     
+     @return The number of bytes written, `0` at the end of the input or on
+             an error.
+     */
+    virtual std::size_t read(char* buffer, std::size_t size) = 0;
+    
+    /// Whether the input ended because of an error
+    virtual bool failed() const {
+        return false;
+    }
+    
+    /**
+     Make a pending `read`, and any later one, return `0` soon. ReadAhead
+     calls this from its own thread when it stops before the end of the
+     input. Sources whose reads can block indefinitely, such as sockets or
+     pipes, should override it, otherwise stopping waits for the current
+     read to return.
+     */
+    virtual void cancel() {}
+};
+
+/**
+ Metrics of a read-ahead parse.
+ */
+struct ReadAheadStats {
+    /// Buffers filled by the reader thread
+    std::size_t buffers;
+    
+    /// Bytes read from the stream
+    std::size_t bytes;
+    
+    /// How many times, and for how long, the parser waited for the reader
+    std::size_t parserStalls;
+    double parserStallSeconds;
+    
+    /// How many times, and for how long, the reader waited for a free buffer
+    std::size_t readerStalls;
+    double readerStallSeconds;
+    
+    ReadAheadStats() : buffers(), bytes(), parserStalls(), parserStallSeconds(), readerStalls(), readerStallSeconds() {}
+};
+
+/**
+ ReadAhead reads a stream or other InputSource on a background thread into
+ a ring of buffers, so that reading and parsing overlap. The consumer gets
+ each filled buffer in place and hands it back by asking for the next one.
+ 
+ Destroying a ReadAhead before the end of the input, for instance when the
+ parse stops early, cancels the source and joins the reader thread. A read
+ from a `std::istream` can't be interrupted, so with a stream the destructor
+ waits for the read in progress to return. Read from an InputSource that
+ implements `cancel` when the input may stall indefinitely.
+ */
+class ReadAhead {
+public:
+    /**
+     Start reading.
+     
+     @param bufferSize The size of each buffer.
+     @param depth The number of buffers, at least 2.
+     */
+    ReadAhead(std::istream& is, std::size_t bufferSize, std::size_t depth);
+    
+    /**
+     Start reading from a source, which must outlive the ReadAhead.
+     */
+    ReadAhead(InputSource& source, std::size_t bufferSize, std::size_t depth);
+    
+    /// Stop reading, cancel the source and wait for the reader thread
+    ~ReadAhead();
+    
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+    
+    /**
+     Release the previous buffer and get the next one, waiting for the reader
+     if necessary. The buffer is valid until the next call.
+     
+     @return `false` at the end of the stream.
+     */
+    bool next(const char*& data, std::size_t& length);
+    
+    /**
+     Metrics so far. Call after the reader is done for complete reader
+     metrics.
+     */
+    ReadAheadStats stats() const;
+    
+private:
+    struct Buffer {
+        std::unique_ptr<char[]> data;
+        std::size_t length;
+    };
+    
+    void start(std::size_t depth);
+    void read();
+    
+private:
+    std::unique_ptr<InputSource> _streamSource;
+    InputSource& _source;
+    const std::size_t _bufferSize;
+    std::vector<Buffer> _buffers;
+    
+    mutable std::mutex _mutex;
+    std::condition_variable _filled;
+    std::condition_variable _released;
+    
+    /// Buffers are filled at `_tail`, consumed at `_head` and handed back up
+    /// to `_free`, all counting up
+    std::size_t _tail;
+    std::size_t _head;
+    std::size_t _free;
+    bool _holding;
+    bool _done;
+    bool _stopping;
+    ReadAheadStats _stats;
+    
+    std::thread _thread;
+};
+
+} // namespace lxml
@@ -0,0 +1,196 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "RecordScanner.h"
+#include "Whitespace.h"
+
+#include <cstring>
+
+namespace lxml {
+
+static const std::size_t npos = std::string::npos;
+
+static bool isNameEnd(char c) {
+    return c == '>' || c == '/' || isXmlSpace(c);
+}
+
+std::size_t RecordScanner::find(std::size_t position, const char* string) const {
+    std::size_t length = std::strlen(string);
+    while (position + length <= _length) {
+        const void* match = std::memchr(_data + position, string[0], _length - position - length + 1);
+        if (!match)
+            return npos;
+
+        position = static_cast<const char*>(match) - _data;
+        if (std::memcmp(_data + position, string, length) == 0)
+            return position;
+        position += 1;
+    }
+    return npos;
+}
+
+std::size_t RecordScanner::skipDoctype(std::size_t position) const {
+    // Skip the internal subset, including the quoted literals and comments
+    // in it, up to the closing '>'
+    int brackets = 0;
+    while (position < _length) {
+        char c = _data[position];
+        if (c == '"' || c == '\'') {
+            const void* quote = std::memchr(_data + position + 1, c, _length - position - 1);
+            if (!quote)
+                return npos;
+            position = static_cast<const char*>(quote) - _data;
+        } else if (c == '<' && _length - position >= 4 && std::memcmp(_data + position, "<!--", 4) == 0) {
+            position = find(position + 4, "-->");
+            if (position == npos)
+                return npos;
+            position += 2;
+        } else if (c == '[') {
+            brackets += 1;
+        } else if (c == ']') {
+            brackets -= 1;
+        } else if (c == '>' && brackets == 0) {
+            return position + 1;
+        }
+        position += 1;
+    }
+    return npos;
+}
+
+bool RecordScanner::scan(const char* localName, std::size_t chunkSize, RecordLayout& layout) const {
+    layout = RecordLayout();
+
+    // UTF-16 and UTF-32 documents start with a byte order mark or a zero byte
+    if (_length < 2 || _data[0] == 0 || _data[1] == 0)
+        return false;
+    if ((_data[0] == '\xFE' && _data[1] == '\xFF') || (_data[0] == '\xFF' && _data[1] == '\xFE'))
+        return false;
+
+    const std::size_t localNameLength = std::strlen(localName);
+    std::vector<std::string> openNames;
+    std::size_t depth = 0;
+    std::size_t containerDepth = 0;
+    std::size_t chunkStart = 0;
+    bool found = false;
+    bool closed = false;
+
+    std::size_t position = 0;
+    while (position < _length) {
+        const void* tag = std::memchr(_data + position, '<', _length - position);
+        if (!tag)
+            break;
+        position = static_cast<const char*>(tag) - _data;
+        const char* p = _data + position;
+        std::size_t remaining = _length - position;
+
+        if (remaining >= 4 && std::memcmp(p, "<!--", 4) == 0) {
+            position = find(position + 4, "-->");
+            if (position == npos)
+                return false;
+            position += 3;
+        } else if (remaining >= 9 && std::memcmp(p, "<![CDATA[", 9) == 0) {
+            position = find(position + 9, "]]>");
+            if (position == npos)
+                return false;
+            position += 3;
+        } else if (remaining >= 2 && p[1] == '?') {
+            position = find(position + 2, "?>");
+            if (position == npos)
+                return false;
+            position += 2;
+        } else if (remaining >= 2 && p[1] == '!') {
+            if (depth != 0)
+                return false;
+            position = skipDoctype(position + 2);
+            if (position == npos)
+                return false;
+        } else if (remaining >= 2 && p[1] == '/') {
+            std::size_t end = find(position + 2, ">");
+            if (end == npos || depth == 0)
+                return false;
+
+            depth -= 1;
+            if (!found)
+                openNames.pop_back();
+            if (found && !closed && depth < containerDepth) {
+                layout.splits.push_back(position);
+                closed = true;
+            }
+            position = end + 1;
+        } else {
+            std::size_t nameStart = position + 1;
+            std::size_t nameEnd = nameStart;
+            while (nameEnd < _length && !isNameEnd(_data[nameEnd]))
+                nameEnd += 1;
+
+            // Skip attributes, '>' may appear in quoted values
+            std::size_t end = nameEnd;
+            while (end < _length && _data[end] != '>') {
+                if (_data[end] == '"' || _data[end] == '\'') {
+                    const void* quote = std::memchr(_data + end + 1, _data[end], _length - end - 1);
+                    if (!quote)
+                        return false;
+                    end = static_cast<const char*>(quote) - _data;
+                }
+                end += 1;
+            }
+            if (end == _length || closed)
+                return false;
+            bool empty = _data[end - 1] == '/';
+
+            if (!found) {
+                const char* name = _data + nameStart;
+                std::size_t nameLength = nameEnd - nameStart;
+                const void* colon = std::memchr(name, ':', nameLength);
+                if (colon) {
+                    nameLength -= static_cast<const char*>(colon) + 1 - name;
+                    name = static_cast<const char*>(colon) + 1;
+                }
+
+                if (nameLength == localNameLength && std::memcmp(name, localName, nameLength) == 0) {
+                    if (depth == 0)
+                        return false;
+
+                    found = true;
+                    containerDepth = depth;
+                    layout.preludeLength = position;
+                    layout.splits.push_back(position);
+                    chunkStart = position;
+                    for (auto it = openNames.rbegin(); it != openNames.rend(); ++it)
+                        layout.suffix += "</" + *it + ">";
+                } else if (!empty) {
+                    openNames.push_back(std::string(_data + nameStart, nameEnd - nameStart));
+                }
+            } else if (depth == containerDepth && position - chunkStart >= chunkSize) {
+                layout.splits.push_back(position);
+                chunkStart = position;
+            }
+
+            if (!empty)
+                depth += 1;
+            position = end + 1;
+        }
+    }
+
+    return found && closed && depth == 0;
+}
+
+} // namespace lxml
@@ -0,0 +1,87 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace lxml {
+
+/**
+ The layout of a document made of many sibling records, as found by
+ RecordScanner. Every slice between consecutive split points holds whole
+ records and, prefixed with the prelude and followed by the suffix, forms a
+ well-formed document.
+ */
+struct RecordLayout {
+    /// The length of the prelude: everything before the first record
+    std::size_t preludeLength;
+    
+    /// Offsets of chunk boundaries, from the first record to the end of the
+    /// last one
+    std::vector<std::size_t> splits;
+    
+    /// Closing tags for the elements open around the records
+    std::string suffix;
+    
+    RecordLayout() : preludeLength() {}
+};
+
+/**
+ RecordScanner finds the boundaries of records in a document without
+ parsing it. It only tracks tags, skipping comments, CDATA sections,
+ processing instructions, the document type declaration and attribute
+ values, so it runs at close to memory speed.
+ 
+ Records are the children of the element that contains the first element
+ with the record name. Names are compared without their prefix, since
+ namespaces are not resolved. Scanning fails, meaning the document can't be split
+ safely, when:
+ - The document is not in an ASCII compatible encoding.
+ - No record is found, or the record is the document element.
+ - Elements follow the container of the records.
+ - The document is truncated or a construct is not terminated.
+ */
+class RecordScanner {
+public:
+    RecordScanner(const char* data, std::size_t length) : _data(data), _length(length) {}
+    
+    /**
+     Scan the document.
+     
+     @param localName The local name of record elements.
+     @param chunkSize The minimum size of each chunk. Chunks end at the first
+                      record boundary after this size.
+     @return `true` if the document can be split at record boundaries.
+     */
+    bool scan(const char* localName, std::size_t chunkSize, RecordLayout& layout) const;
+    
+private:
+    std::size_t find(std::size_t position, const char* string) const;
+    std::size_t skipDoctype(std::size_t position) const;
+    
+private:
+    const char* _data;
+    std::size_t _length;
+};
+
+} // namespace lxml
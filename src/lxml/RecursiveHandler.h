@@ -19,12 +19,35 @@
 // DEALINGS IN THE SOFTWARE.
 
 #pragma once
+#include "AttributeView.h"
 #include "QName.h"
 #include <map>
 #include <string>
+#include <string_view>
 
 namespace lxml {
 
+/**
+ ContentPolicy specifies what a recursive handler does with the text
+ contents of the elements it handles.
+ */
+enum class ContentPolicy {
+    /// Text is dropped without being buffered, `endElement` gets empty
+    /// contents.
+    Ignore,
+    
+    /// Text is passed to `characters` as it arrives and is not buffered,
+    /// `endElement` gets empty contents.
+    Stream,
+    
+    /// Text is concatenated and passed to `endElement`.
+    Accumulate,
+    
+    /// Text is concatenated and passed to `endElement` without leading or
+    /// trailing whitespace.
+    AccumulateTrimmed
+};
+
 /**
  RecursiveHandler is a base abstract class defining event methods for a
  recursive SAX event handler. This is similar to SAXHandler, but recursive
@@ -34,7 +57,7 @@ namespace lxml {
  */
 class RecursiveHandler {
 public:
-    typedef std::map<QName, std::string> AttributeMap;
+    typedef AttributeView::Map AttributeMap;
     
 public:
     /**
@@ -44,9 +67,11 @@ public:
      method in a recursive handler.
      
      @param qname The qualified name of the element.
-     @param attributes All attributes present in the element.
+     @param attributes All attributes present in the element. The view is
+                       only valid during this call, use `toMap` to keep a
+                       copy.
      */
-    virtual void startElement(const QName& qname, const AttributeMap& attributes) = 0;
+    virtual void startElement(const QName& qname, const AttributeView& attributes) = 0;
     
     /**
      This method is called when an element's closing tag is encountered in
@@ -54,10 +79,11 @@ public:
      `startElement` unless there is a parsing error.
      
      @param qname The qualified name of the element.
-     @param contents The concatenated and trimmed text contents of the
-                     element.
+     @param contents The concatenated text contents of the element, as
+                     specified by `contentPolicy`. The view is only valid
+                     during this call.
      */
-    virtual void endElement(const QName& qname, const std::string& contents) = 0;
+    virtual void endElement(const QName& qname, std::string_view contents) = 0;
     
     /**
      This method is called when a sub-element's opening tag is encountered
@@ -81,6 +107,27 @@ public:
                     element.
      */
     virtual void endSubElement(const QName& qname, RecursiveHandler* handler) = 0;
+    
+    /**
+     Specify what to do with the text contents of elements handled by this
+     handler. This is queried every time the handler starts an element. The
+     default is `ContentPolicy::Accumulate`.
+     */
+    virtual ContentPolicy contentPolicy() const {
+        return ContentPolicy::Accumulate;
+    }
+    
+    /**
+     This method is called with text contents as they are parsed when
+     `contentPolicy` is `ContentPolicy::Stream`. Text may be split across
+     several calls.
+     
+     @param chars  The characters, not null terminated.
+     @param length The number of characters.
+     */
+    virtual void characters(const char* chars, std::size_t length) {
+        
+    }
 };
 
 } // namespace lxml
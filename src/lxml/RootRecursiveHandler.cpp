@@ -19,58 +19,149 @@
 // DEALINGS IN THE SOFTWARE.
 
 #include "RootRecursiveHandler.h"
+#include "ParseContext.h"
+#include "Whitespace.h"
 #include <cassert>
+#include <new>
 
 namespace lxml {
 
-RootRecursiveHandler::RootRecursiveHandler(RecursiveHandler* rootHandler) : _rootHandler(rootHandler) {
+// Pooled buffers larger than this are released once their element ends
+static const std::size_t kMaxPooledBufferSize = 1024*1024;
+
+static std::string_view trimmed(const std::pmr::string& string) {
+    // Leading whitespace is never buffered
+    const char* first = string.data();
+    return std::string_view(first, skipSpaceBackward(first, first + string.size()) - first);
+}
+
+RootRecursiveHandler::RootRecursiveHandler() : _rootHandler(), _bufferCount(), _recordCount() {
+}
+
+RootRecursiveHandler::RootRecursiveHandler(RecursiveHandler* rootHandler) : _rootHandler(rootHandler), _bufferCount(), _recordCount() {
+    assert(rootHandler != 0);
+}
+
+void RootRecursiveHandler::reset(RecursiveHandler* rootHandler) {
     assert(rootHandler != 0);
+    _rootHandler = rootHandler;
+    _handlerStack.clear();
+    _bufferCount = 0;
+    _recordCount = 0;
+}
+
+void RootRecursiveHandler::setMemoryResource(std::pmr::memory_resource* resource) {
+    // Containers can't change their allocator, rebuild them in place
+    _handlerStack.~vector();
+    new (&_handlerStack) std::pmr::vector<Frame>(resource);
+    _contents.~vector();
+    new (&_contents) std::pmr::vector<std::pmr::string>(resource);
+    _bufferCount = 0;
 }
 
 void RootRecursiveHandler::startDocument() {
+    assert(_rootHandler != 0);
     assert(_handlerStack.empty());
 }
 
 void RootRecursiveHandler::endDocument() {
-    assert(_handlerStack.empty());
+    // Truncated documents end with open elements, `reset` discards them
+}
+
+void RootRecursiveHandler::pushFrame(RecursiveHandler* handler) {
+    Frame frame = { handler, ContentPolicy::Ignore, kNoBuffer };
+    if (handler)
+        frame.policy = handler->contentPolicy();
+
+    if (frame.policy == ContentPolicy::Accumulate || frame.policy == ContentPolicy::AccumulateTrimmed) {
+        if (_bufferCount == _contents.size())
+            _contents.emplace_back();
+        else
+            _contents[_bufferCount].clear();
+        frame.buffer = _bufferCount++;
+    }
+
+    _handlerStack.push_back(frame);
 }
 
-void RootRecursiveHandler::startElement(const QName& qname, const NamespaceMap& namespaces, const AttributeMap& attributes) {
+void RootRecursiveHandler::startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
     if (_handlerStack.empty()) {
         // Root element
         _rootHandler->startElement(qname, attributes);
-        _handlerStack.push_back(_rootHandler);
+        pushFrame(_rootHandler);
     } else {
-        RecursiveHandler* handler = _handlerStack.back();
+        RecursiveHandler* handler = _handlerStack.back().handler;
         RecursiveHandler* childHandler = 0;
         if (handler) {
             childHandler = handler->startSubElement(qname);
             if (childHandler)
                 childHandler->startElement(qname, attributes);
         }
-        _handlerStack.push_back(childHandler);
+        if (!childHandler) {
+            // Nobody handles this subtree, let libxml2 skip to its end
+            if (ParseContext* context = ParseContext::current())
+                context->skipSubtree();
+        }
+        pushFrame(childHandler);
     }
-
-    _contents.emplace_back();
 }
 
 void RootRecursiveHandler::endElement(const QName& qname) {
-    RecursiveHandler* handler = _handlerStack.back();
-    if (handler)
-        handler->endElement(qname, _contents.back());
+    const Frame& frame = _handlerStack.back();
+    RecursiveHandler* handler = frame.handler;
+    if (frame.buffer != kNoBuffer) {
+        std::pmr::string& buffer = _contents[frame.buffer];
+        if (frame.policy == ContentPolicy::AccumulateTrimmed)
+            handler->endElement(qname, trimmed(buffer));
+        else
+            handler->endElement(qname, buffer);
+
+        if (buffer.capacity() > kMaxPooledBufferSize)
+            std::pmr::string(buffer.get_allocator()).swap(buffer);
+        --_bufferCount;
+    } else if (handler) {
+        handler->endElement(qname, std::string_view());
+    }
 
     _handlerStack.pop_back();
-    _contents.pop_back();
 
     if (!_handlerStack.empty()) {
-        RecursiveHandler* parentHandler = _handlerStack.back();
+        RecursiveHandler* parentHandler = _handlerStack.back().handler;
         if (parentHandler)
             parentHandler->endSubElement(qname, handler);
+        if (_handlerStack.size() == 1)
+            ++_recordCount;
     }
 }
 
 void RootRecursiveHandler::characters(const char* chars, std::size_t length) {
-    _contents.back() += std::string(chars, length);
+    if (_handlerStack.empty())
+        return;
+
+    const Frame& frame = _handlerStack.back();
+    switch (frame.policy) {
+        case ContentPolicy::Ignore:
+            break;
+
+        case ContentPolicy::Stream:
+            frame.handler->characters(chars, length);
+            break;
+
+        case ContentPolicy::Accumulate:
+            _contents[frame.buffer].append(chars, length);
+            break;
+
+        case ContentPolicy::AccumulateTrimmed: {
+            std::pmr::string& buffer = _contents[frame.buffer];
+            if (buffer.empty()) {
+                const char* first = skipSpace(chars, chars + length);
+                length -= first - chars;
+                chars = first;
+            }
+            buffer.append(chars, length);
+            break;
+        }
+    }
 }
 
 void RootRecursiveHandler::error(const xmlError& error) {
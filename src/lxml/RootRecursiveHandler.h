@@ -22,6 +22,7 @@
 #include "SAXHandler.h"
 #include "RecursiveHandler.h"
 
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -31,26 +32,68 @@ namespace lxml {
  RootRecursiveHandler is a SAXHandler that dispatches events to instances
  of RecursiveHandler.
  
+ Text is handled according to each handler's ContentPolicy. Content
+ buffers are pooled by depth and reused across elements and documents.
+ Subtrees for which `startSubElement` returns `0` are skipped by the parser
+ without events.
+ 
  @see RecursiveHandler
  @see SAXHandler
  */
 class RootRecursiveHandler : public SAXHandler {
 public:
+    RootRecursiveHandler();
     explicit RootRecursiveHandler(RecursiveHandler* rootHandler);
     
+    /**
+     Set the handler for the root element and discard any state left by a
+     previous document. Allocated stack capacity is kept.
+     */
+    void reset(RecursiveHandler* rootHandler);
+    
+    /**
+     Allocate handler stacks and content buffers from a memory resource.
+     This discards any state and pooled buffers, which is required before
+     the previous resource is released.
+     */
+    void setMemoryResource(std::pmr::memory_resource* resource);
+    
+    /**
+     The number of children of the document element that have ended since
+     the last `reset`.
+     */
+    std::size_t recordCount() const {
+        return _recordCount;
+    }
+    
     virtual void startDocument();
     virtual void endDocument();
     
-    virtual void startElement(const QName& qname, const NamespaceMap& namespaces, const AttributeMap& attributes);
+    virtual void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes);
     virtual void endElement(const QName& qname);
     
     virtual void characters(const char* chars, std::size_t length);
     virtual void error(const xmlError& error);
     
+private:
+    static const std::size_t kNoBuffer = static_cast<std::size_t>(-1);
+    
+    struct Frame {
+        RecursiveHandler* handler;
+        ContentPolicy policy;
+        std::size_t buffer;
+    };
+    
+    void pushFrame(RecursiveHandler* handler);
+    
 private:
     RecursiveHandler* _rootHandler;
-    std::vector<RecursiveHandler*> _handlerStack;
-    std::vector<std::string> _contents;
+    std::pmr::vector<Frame> _handlerStack;
+    
+    /// Content buffers, the first `_bufferCount` are in use
+    std::pmr::vector<std::pmr::string> _contents;
+    std::size_t _bufferCount;
+    std::size_t _recordCount;
 };
 
 } // namespace lxml
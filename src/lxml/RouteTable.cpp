@@ -0,0 +1,86 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "RouteTable.h"
+
+namespace lxml {
+
+RouteTable::RouteTable() : _allInterned(true), _mask() {
+}
+
+std::size_t RouteTable::insert(const QName& qname) {
+    std::size_t index = findContent(qname);
+    if (index != npos)
+        return index;
+
+    _names.push_back(qname);
+    _allInterned = _allInterned && qname.isInterned();
+    rebuild();
+    return _names.size() - 1;
+}
+
+std::size_t RouteTable::findPointer(const QName& qname) const {
+    if (_names.empty())
+        return npos;
+
+    for (std::size_t slot = pointerHash(qname) & _mask; _pointerSlots[slot] != 0; slot = (slot + 1) & _mask) {
+        const QName& name = _names[_pointerSlots[slot] - 1];
+        if (name.localName() == qname.localName() && name.namespaceURI() == qname.namespaceURI() && name.prefix() == qname.prefix())
+            return _pointerSlots[slot] - 1;
+    }
+    return npos;
+}
+
+std::size_t RouteTable::findContent(const QName& qname) const {
+    if (_names.empty())
+        return npos;
+
+    for (std::size_t slot = qname.hash() & _mask; _contentSlots[slot] != 0; slot = (slot + 1) & _mask) {
+        const QName& name = _names[_contentSlots[slot] - 1];
+        if (name == qname)
+            return _contentSlots[slot] - 1;
+    }
+    return npos;
+}
+
+void RouteTable::rebuild() {
+    // Keep the load factor under one half so that probes stay short
+    std::size_t capacity = 8;
+    while (capacity < _names.size() * 2)
+        capacity *= 2;
+    _mask = capacity - 1;
+
+    _pointerSlots.assign(capacity, 0);
+    _contentSlots.assign(capacity, 0);
+    for (std::size_t i = 0; i < _names.size(); i += 1) {
+        std::size_t slot = pointerHash(_names[i]) & _mask;
+        while (_pointerSlots[slot] != 0)
+            slot = (slot + 1) & _mask;
+        _pointerSlots[slot] = static_cast<std::uint32_t>(i + 1);
+
+        slot = _names[i].hash() & _mask;
+        while (_contentSlots[slot] != 0)
+            slot = (slot + 1) & _mask;
+        _contentSlots[slot] = static_cast<std::uint32_t>(i + 1);
+    }
+}
+
+} // namespace lxml
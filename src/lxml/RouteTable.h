@@ -0,0 +1,94 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "QName.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lxml {
+
+/**
+ RouteTable maps qualified names to consecutive indices with O(1) lookups.
+ 
+ Lookups of interned names against a table of interned names only compare
+ dictionary pointers and never read the strings. Other lookups use the
+ QName content hash. Names are not copied, their strings must outlive the
+ table.
+ */
+class RouteTable {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    
+public:
+    RouteTable();
+    
+    /**
+     Add a name to the table.
+     
+     @return The index of the name, which is the existing index if the name
+             was already added.
+     */
+    std::size_t insert(const QName& qname);
+    
+    /**
+     Find the index of a name.
+     
+     @return The index of the name or `npos` if it is not in the table.
+     */
+    std::size_t find(const QName& qname) const {
+        if (qname.isInterned() && _allInterned)
+            return findPointer(qname);
+        return findContent(qname);
+    }
+    
+    std::size_t size() const {
+        return _names.size();
+    }
+    
+    const QName& operator[](std::size_t index) const {
+        return _names[index];
+    }
+    
+private:
+    static std::size_t pointerHash(const QName& qname) {
+        std::uintptr_t hash = reinterpret_cast<std::uintptr_t>(qname.localName()) * 0x9E3779B97F4A7C15ull;
+        hash ^= reinterpret_cast<std::uintptr_t>(qname.namespaceURI()) * 0xC2B2AE3D27D4EB4Full;
+        return static_cast<std::size_t>(hash ^ (hash >> 29));
+    }
+    
+    std::size_t findPointer(const QName& qname) const;
+    std::size_t findContent(const QName& qname) const;
+    void rebuild();
+    
+private:
+    std::vector<QName> _names;
+    bool _allInterned;
+    
+    /// Open addressed slots holding a name index plus one, `0` when empty
+    std::vector<std::uint32_t> _pointerSlots;
+    std::vector<std::uint32_t> _contentSlots;
+    std::size_t _mask;
+};
+
+} // namespace lxml
@@ -0,0 +1,197 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "BaseRecursiveHandler.h"
+#include "RouteTable.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lxml {
+
+/**
+ RouterHandler is a recursive handler that dispatches sub-elements by name.
+ Child names are registered once with `route` and looked up in constant time
+ for every sub-element, which suits elements with many possible children
+ better than a chain of comparisons in `startSubElement`. Register interned
+ names from the parser's SymbolTable to dispatch by pointer only.
+ 
+ The router records which routes were seen in the current element so that
+ required children can be checked in `endElement`. The record is saved
+ around routed sub-elements, so a router may route to itself for recursive
+ elements. Subclasses that override `startElement` must call
+ `RouterHandler::startElement`.
+ */
+template <typename T>
+class RouterHandler : public BaseRecursiveHandler<T> {
+public:
+    typedef std::function<void(std::string_view)> TextCallback;
+    
+public:
+    RouterHandler() : _routeStack(), _savedSeen() {}
+    
+    /**
+     Route a sub-element to a handler.
+     
+     @param onEnd Called with the handler when the sub-element ends.
+     @return The route index, used with `seen`.
+     */
+    template <typename H>
+    std::size_t route(const QName& qname, H& handler, std::function<void(H&)> onEnd = std::function<void(H&)>(), bool required = false) {
+        std::function<void(RecursiveHandler*)> callback;
+        if (onEnd)
+            callback = [onEnd](RecursiveHandler* handler) { onEnd(*static_cast<H*>(handler)); };
+        return addRoute(qname, &handler, std::move(callback), required);
+    }
+    
+    /**
+     Route a sub-element's trimmed text contents to a callback. Elements
+     nested in the sub-element are ignored.
+     */
+    std::size_t routeText(const QName& qname, TextCallback onText, bool required = false) {
+        std::size_t index = addRoute(qname, &_textHandler, std::function<void(RecursiveHandler*)>(), required);
+        _routes[index].onText = std::move(onText);
+        return index;
+    }
+    
+    /// Whether the route at `index` was seen in the current element
+    bool seen(std::size_t index) const {
+        return (_seen[index / 64] >> (index % 64)) & 1;
+    }
+    
+    /// Whether all required routes were seen in the current element
+    bool hasRequired() const {
+        for (std::size_t i = 0; i < _required.size(); i += 1) {
+            if ((_seen[i] & _required[i]) != _required[i])
+                return false;
+        }
+        return true;
+    }
+    
+    /// The required routes that were not seen in the current element
+    std::vector<QName> missingRequired() const {
+        std::vector<QName> missing;
+        for (std::size_t i = 0; i < _routes.size(); i += 1) {
+            if (_routes[i].required && !seen(i))
+                missing.push_back(_table[i]);
+        }
+        return missing;
+    }
+    
+    virtual void startElement(const QName& qname, const AttributeView& attributes) {
+        std::fill(_seen.begin(), _seen.end(), 0);
+    }
+    
+    virtual RecursiveHandler* startSubElement(const QName& qname) {
+        std::size_t index = _table.find(qname);
+        _routeStack.push_back(index);
+        if (index == RouteTable::npos)
+            return 0;
+        
+        _seen[index / 64] |= std::uint64_t(1) << (index % 64);
+        if (_routes[index].onText) {
+            _textHandler.setCallback(&_routes[index].onText);
+            return &_textHandler;
+        }
+        
+        // The handler may lead back to this router, which would clear the
+        // seen routes of this element in startElement
+        _savedSeen.insert(_savedSeen.end(), _seen.begin(), _seen.end());
+        return _routes[index].handler;
+    }
+    
+    virtual void endSubElement(const QName& qname, RecursiveHandler* handler) {
+        std::size_t index = _routeStack.back();
+        _routeStack.pop_back();
+        if (index == RouteTable::npos || _routes[index].onText)
+            return;
+        
+        std::copy(_savedSeen.end() - _seen.size(), _savedSeen.end(), _seen.begin());
+        _savedSeen.resize(_savedSeen.size() - _seen.size());
+        if (_routes[index].onEnd)
+            _routes[index].onEnd(handler);
+    }
+    
+private:
+    struct Route {
+        RecursiveHandler* handler;
+        std::function<void(RecursiveHandler*)> onEnd;
+        TextCallback onText;
+        bool required;
+    };
+    
+    /// Delivers contents from `endElement`, while they are still valid
+    class TextHandler : public RecursiveHandler {
+    public:
+        TextHandler() : _callback() {}
+        void setCallback(const TextCallback* callback) {
+            _callback = callback;
+        }
+        ContentPolicy contentPolicy() const {
+            return ContentPolicy::AccumulateTrimmed;
+        }
+        void startElement(const QName& qname, const AttributeView& attributes) {}
+        void endElement(const QName& qname, std::string_view contents) {
+            (*_callback)(contents);
+        }
+        RecursiveHandler* startSubElement(const QName& qname) {
+            return 0;
+        }
+        void endSubElement(const QName& qname, RecursiveHandler* handler) {}
+        
+    private:
+        const TextCallback* _callback;
+    };
+    
+    std::size_t addRoute(const QName& qname, RecursiveHandler* handler, std::function<void(RecursiveHandler*)> onEnd, bool required) {
+        std::size_t index = _table.insert(qname);
+        if (index == _routes.size())
+            _routes.push_back(Route());
+        _routes[index].handler = handler;
+        _routes[index].onEnd = std::move(onEnd);
+        _routes[index].onText = TextCallback();
+        _routes[index].required = required;
+        
+        std::size_t words = (_routes.size() + 63) / 64;
+        _seen.resize(words);
+        _required.resize(words);
+        if (required)
+            _required[index / 64] |= std::uint64_t(1) << (index % 64);
+        else
+            _required[index / 64] &= ~(std::uint64_t(1) << (index % 64));
+        return index;
+    }
+    
+private:
+    RouteTable _table;
+    std::vector<Route> _routes;
+    std::vector<std::uint64_t> _seen;
+    std::vector<std::uint64_t> _required;
+    std::vector<std::size_t> _routeStack;
+    std::vector<std::uint64_t> _savedSeen;
+    TextHandler _textHandler;
+};
+
+} // namespace lxml
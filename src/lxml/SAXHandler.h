@@ -19,6 +19,8 @@
 // DEALINGS IN THE SOFTWARE.
 
 #pragma once
+#include "AttributeView.h"
+#include "NamespaceView.h"
 #include "QName.h"
 
 #include <libxml/parser.h>
@@ -29,17 +31,21 @@ namespace lxml {
 
 /**
  SAXHandler is a base abstract class defining SAX event methods.
+ 
+ Namespaces and attributes are delivered as views over libxml2's buffers
+ so that no allocation happens unless the handler asks for it. Subclass
+ MapSAXHandler to receive them as maps instead.
  */
 class SAXHandler {
 public:
-    typedef std::map<const char*, const char*> NamespaceMap;
-    typedef std::map<QName, std::string> AttributeMap;
+    typedef NamespaceView::Map NamespaceMap;
+    typedef AttributeView::Map AttributeMap;
     
 public:
     virtual void startDocument() = 0;
     virtual void endDocument() = 0;
     
-    virtual void startElement(const QName& qname, const NamespaceMap& namespaces, const AttributeMap& attributes) = 0;
+    virtual void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) = 0;
     virtual void endElement(const QName& qname) = 0;
     
     virtual void characters(const char* chars, std::size_t length) = 0;
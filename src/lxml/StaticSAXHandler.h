@@ -0,0 +1,173 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "AttributeView.h"
+#include "NamespaceView.h"
+#include "ParseState.h"
+#include "QName.h"
+#include "RecursiveHandler.h"
+#include "SAXHandler.h"
+
+#include <cstddef>
+#include <libxml/parser.h>
+#include <type_traits>
+#include <utility>
+
+namespace lxml {
+
+/**
+ isStaticHandler is true for handler types that are parsed with statically
+ dispatched callbacks: any class that is neither a SAXHandler nor a
+ RecursiveHandler. Such a handler implements any subset of the SAXHandler
+ methods, non-virtually:
+ 
+     void startDocument();
+     void endDocument();
+     void startElement(const QName&, const NamespaceView&, const AttributeView&);
+     void endElement(const QName&);
+     void characters(const char*, std::size_t);
+     void error(const xmlError&);
+ 
+ The callbacks call these methods directly so the compiler can inline them.
+ Events the handler does not implement are not registered with libxml2 at
+ all, a handler without `characters` never pays for text callbacks.
+ */
+template <typename Handler>
+constexpr bool isStaticHandler = std::is_class<Handler>::value
+    && !std::is_base_of<SAXHandler, Handler>::value
+    && !std::is_base_of<RecursiveHandler, Handler>::value;
+
+template <typename Handler, typename = void>
+struct HasStartDocument : std::false_type {};
+template <typename Handler>
+struct HasStartDocument<Handler, std::void_t<decltype(std::declval<Handler&>().startDocument())>> : std::true_type {};
+
+template <typename Handler, typename = void>
+struct HasEndDocument : std::false_type {};
+template <typename Handler>
+struct HasEndDocument<Handler, std::void_t<decltype(std::declval<Handler&>().endDocument())>> : std::true_type {};
+
+template <typename Handler, typename = void>
+struct HasStartElement : std::false_type {};
+template <typename Handler>
+struct HasStartElement<Handler, std::void_t<decltype(std::declval<Handler&>().startElement(std::declval<const QName&>(), std::declval<const NamespaceView&>(), std::declval<const AttributeView&>()))>> : std::true_type {};
+
+template <typename Handler, typename = void>
+struct HasEndElement : std::false_type {};
+template <typename Handler>
+struct HasEndElement<Handler, std::void_t<decltype(std::declval<Handler&>().endElement(std::declval<const QName&>()))>> : std::true_type {};
+
+template <typename Handler, typename = void>
+struct HasCharacters : std::false_type {};
+template <typename Handler>
+struct HasCharacters<Handler, std::void_t<decltype(std::declval<Handler&>().characters(std::declval<const char*>(), std::declval<std::size_t>()))>> : std::true_type {};
+
+template <typename Handler, typename = void>
+struct HasError : std::false_type {};
+template <typename Handler>
+struct HasError<Handler, std::void_t<decltype(std::declval<Handler&>().error(std::declval<const xmlError&>()))>> : std::true_type {};
+
+/**
+ StaticSAXHandler generates libxml2 callbacks specialized for a concrete
+ handler type. `Stats` is NoStats, CountElements or CollectStats.
+ */
+template <typename Handler, typename Stats = NoStats>
+class StaticSAXHandler {
+public:
+    /**
+     The libxml2 callback table for `Handler`. The user data must be a
+     ParseState whose handler points to a `Handler`.
+     */
+    static const xmlSAXHandler& table() {
+        static const xmlSAXHandler sax = makeTable();
+        return sax;
+    }
+    
+private:
+    static Handler& handler(void* ctx) {
+        return *static_cast<Handler*>(static_cast<ParseState*>(ctx)->handler);
+    }
+    
+    static void startDocument(void* ctx) {
+        handler(ctx).startDocument();
+    }
+    
+    static void endDocument(void* ctx) {
+        handler(ctx).endDocument();
+    }
+    
+    static void startElementNs(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* URI, int nb_namespaces, const xmlChar** namespaces, int nb_attributes, int nb_defaulted, const xmlChar** attributes) {
+        ParseState* state = static_cast<ParseState*>(ctx);
+        if (!state->willStartElement())
+            return;
+        Stats::startElement(*state, nb_attributes);
+        if constexpr (HasStartElement<Handler>::value) {
+            typename Stats::Timer timer(*state);
+            handler(ctx).startElement(state->qname(localname, prefix, URI),
+                                      NamespaceView(namespaces, nb_namespaces),
+                                      AttributeView(attributes, nb_attributes, state->symbols));
+        }
+        state->didStartElement();
+    }
+    
+    static void endElementNs(void* ctx, const xmlChar* localname, const xmlChar* prefix, const xmlChar* URI) {
+        ParseState* state = static_cast<ParseState*>(ctx);
+        typename Stats::Timer timer(*state);
+        handler(ctx).endElement(state->qname(localname, prefix, URI));
+    }
+    
+    static void characters(void* ctx, const xmlChar* ch, int len) {
+        ParseState* state = static_cast<ParseState*>(ctx);
+        Stats::characters(*state, len);
+        typename Stats::Timer timer(*state);
+        handler(ctx).characters(reinterpret_cast<const char*>(ch), static_cast<std::size_t>(len));
+    }
+    
+    static void error(void* ctx, ParseErrorPtr error) {
+        if constexpr (HasError<Handler>::value)
+            handler(ctx).error(*error);
+    }
+    
+    static xmlSAXHandler makeTable() {
+        xmlSAXHandler sax = xmlSAXHandler();
+        sax.initialized = XML_SAX2_MAGIC;
+        
+        // Always handle errors so that libxml2 doesn't print them
+        sax.serror = error;
+        
+        if constexpr (HasStartDocument<Handler>::value)
+            sax.startDocument = startDocument;
+        if constexpr (HasEndDocument<Handler>::value)
+            sax.endDocument = endDocument;
+        // Budgets and statistics count elements even when the handler
+        // doesn't want them
+        if constexpr (HasStartElement<Handler>::value || Stats::countsElements)
+            sax.startElementNs = startElementNs;
+        if constexpr (HasEndElement<Handler>::value)
+            sax.endElementNs = endElementNs;
+        if constexpr (HasCharacters<Handler>::value)
+            sax.characters = characters;
+        return sax;
+    }
+};
+
+} // namespace lxml
@@ -19,28 +19,33 @@
 // DEALINGS IN THE SOFTWARE.
 
 #include "StringHandler.h"
+#include "Whitespace.h"
 
 namespace lxml {
 
-void StringHandler::endElement(const QName& qname, const std::string& contents) {
-    _result = trim(contents);
+void StringHandler::startElement(const QName& qname, const AttributeView& attributes) {
+    _result.clear();
 }
 
-std::string StringHandler::trim(const std::string& string) {
-    // Trim whitespace at the start
-    auto first = string.begin();
-    while (first != string.end() && std::isspace(*first))
-        ++first;
-    
-    // Trim whitespace at the end
-    auto rlast = string.rbegin();
-    while (rlast != string.rend() && std::isspace(*rlast))
-        ++rlast;
-    
-    auto last = rlast.base();
-    if (last <= first)
-        return std::string();
-    return std::string(first, last);
+void StringHandler::endElement(const QName& qname, std::string_view contents) {
+    // Leading whitespace was never appended
+    if (_mode == Mode::Trim)
+        _result.resize(skipSpaceBackward(_result.data(), _result.data() + _result.size()) - _result.data());
+    else if (_mode == Mode::Normalize)
+        _result.resize(normalize(&_result[0], _result.size()));
+}
+
+void StringHandler::characters(const char* chars, std::size_t length) {
+    if (_mode != Mode::Raw && _result.empty()) {
+        const char* first = skipSpace(chars, chars + length);
+        length -= first - chars;
+        chars = first;
+    }
+    _result.append(chars, length);
+}
+
+std::string StringHandler::trim(std::string_view string) {
+    return std::string(lxml::trim(string));
 }
 
 } // namespace lxml
@@ -25,14 +25,46 @@
 namespace lxml {
 
 /**
- StringHandler is a recursive handler that concatenates and trims
- surrounding whitespace from element contents. All sub-elemens are ignored.
+ StringHandler is a recursive handler that concatenates element contents
+ into its result and, by default, trims surrounding whitespace. Contents are
+ appended to the result as they are parsed and trimmed in place, without
+ intermediate copies. All sub-elemens are ignored.
  */
 class StringHandler : public BaseRecursiveHandler<std::string> {
 public:
-    void endElement(const QName& qname, const std::string& contents);
+    enum class Mode {
+        /// Keep the contents as they are
+        Raw,
+        
+        /// Remove whitespace at the start and end
+        Trim,
+        
+        /// Trim, and collapse every run of inner whitespace to a single space
+        Normalize
+    };
     
-    static std::string trim(const std::string& string);
+public:
+    explicit StringHandler(Mode mode = Mode::Trim) : _mode(mode) {}
+    
+    Mode mode() const {
+        return _mode;
+    }
+    void setMode(Mode mode) {
+        _mode = mode;
+    }
+    
+    ContentPolicy contentPolicy() const {
+        return ContentPolicy::Stream;
+    }
+    
+    void startElement(const QName& qname, const AttributeView& attributes);
+    void endElement(const QName& qname, std::string_view contents);
+    void characters(const char* chars, std::size_t length);
+    
+    static std::string trim(std::string_view string);
+    
+private:
+    Mode _mode;
 };
 
 } // namespace lxml
@@ -0,0 +1,50 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "SymbolTable.h"
+
+namespace lxml {
+
+SymbolTable::SymbolTable() : _dict(xmlDictCreate()) {
+}
+
+SymbolTable::~SymbolTable() {
+    xmlDictFree(_dict);
+}
+
+QName SymbolTable::intern(const char* localName, const char* prefix, const char* nsURI) {
+    const char* internedLocalName = internString(localName);
+    const char* internedPrefix = internString(prefix);
+    const char* internedURI = internString(nsURI);
+    return QName::interned(internedLocalName, internedPrefix, internedURI, QName::computeHash(localName, nsURI));
+}
+
+const char* SymbolTable::internString(const char* string) {
+    if (!string)
+        return 0;
+    return reinterpret_cast<const char*>(xmlDictLookup(_dict, reinterpret_cast<const xmlChar*>(string), -1));
+}
+
+std::size_t SymbolTable::size() const {
+    return static_cast<std::size_t>(xmlDictSize(_dict));
+}
+
+} // namespace lxml
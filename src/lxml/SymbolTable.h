@@ -0,0 +1,97 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "QName.h"
+
+#include <libxml/dict.h>
+
+namespace lxml {
+
+/**
+ SymbolTable is a dictionary of names that handlers care about. Register
+ the names once, before parsing, and pass the table in ParseOptions. Names
+ the parser then delivers are interned when all their strings are
+ registered, so comparing them to a registered symbol is a pointer
+ comparison. Other names come from the parser's own dictionary, which
+ differs between parsers and documents, and are compared by content.
+ 
+ The table is only read while parsing, so it can be shared by parsers on
+ any number of threads as long as no names are registered concurrently.
+ */
+class SymbolTable {
+public:
+    SymbolTable();
+    ~SymbolTable();
+    
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+    
+    /**
+     Register a name and return its interned QName.
+     */
+    QName intern(const char* localName, const char* nsURI = 0) {
+        return intern(localName, 0, nsURI);
+    }
+    
+    /**
+     Register a prefixed name and return its interned QName.
+     */
+    QName intern(const char* localName, const char* prefix, const char* nsURI);
+    
+    /**
+     Make a QName for strings delivered by a parser using this table. It is
+     interned if every string is registered in the table.
+     */
+    QName qname(const char* localName, const char* prefix, const char* nsURI) const {
+        if (owns(localName) && owns(prefix) && owns(nsURI))
+            return QName::interned(localName, prefix, nsURI);
+        return QName(localName, prefix, nsURI);
+    }
+    
+    /**
+     Register a string and return its interned copy.
+     */
+    const char* internString(const char* string);
+    
+    /**
+     The number of strings registered.
+     */
+    std::size_t size() const;
+    
+    /**
+     The underlying libxml2 dictionary. Parsers use a sub-dictionary of it.
+     */
+    xmlDictPtr dict() const {
+        return _dict;
+    }
+    
+private:
+    /// Whether a string is null or registered, by pointer
+    bool owns(const char* string) const {
+        return !string || xmlDictOwns(_dict, reinterpret_cast<const xmlChar*>(string)) == 1;
+    }
+    
+private:
+    xmlDictPtr _dict;
+};
+
+} // namespace lxml
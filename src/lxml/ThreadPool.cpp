@@ -0,0 +1,133 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "ThreadPool.h"
+#include "Wait.h"
+
+#include <algorithm>
+
+namespace lxml {
+
+static thread_local std::size_t __worker_index = ThreadPool::npos;
+
+ThreadPool::ThreadPool(std::size_t threads) : _nextQueue(), _pending(), _queued(), _stolen(), _stopping() {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (std::size_t i = 0; i < threads; i += 1)
+        _queues.emplace_back(new Queue);
+    for (std::size_t i = 0; i < threads; i += 1)
+        _threads.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _workAvailable.notify_all();
+    for (std::thread& thread : _threads)
+        thread.join();
+}
+
+std::size_t ThreadPool::currentIndex() {
+    return __worker_index;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    std::size_t index;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        index = _nextQueue;
+        _nextQueue = (_nextQueue + 1) % _queues.size();
+        _pending += 1;
+        _queued += 1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_queues[index]->mutex);
+        _queues[index]->tasks.push_back(std::move(task));
+    }
+    _workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    waitUntil(_idle, lock, [this]() { return _pending == 0; });
+}
+
+bool ThreadPool::take(std::size_t index, std::function<void()>& task) {
+    if (!dequeue(index, task))
+        return false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queued -= 1;
+    return true;
+}
+
+bool ThreadPool::dequeue(std::size_t index, std::function<void()>& task) {
+    {
+        Queue& queue = *_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+
+    for (std::size_t i = 1; i < _queues.size(); i += 1) {
+        Queue& victim = *_queues[(index + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            _stolen += 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(std::size_t index) {
+    __worker_index = index;
+    while (true) {
+        std::function<void()> task;
+        if (take(index, task)) {
+            task();
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending -= 1;
+            if (_pending == 0)
+                _idle.notify_all();
+            continue;
+        }
+
+        // Tasks are counted before they are queued, a worker may see the count
+        // before the task and retry
+        std::unique_lock<std::mutex> lock(_mutex);
+        waitUntil(_workAvailable, lock, [this]() { return _stopping || _queued > 0; });
+        if (_stopping && _queued == 0)
+            return;
+    }
+}
+
+} // namespace lxml
@@ -0,0 +1,112 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lxml {
+
+/**
+ ThreadPool is a work-stealing pool of threads. Each worker has its own
+ queue and runs its tasks in submission order. A worker whose queue is empty
+ steals from the back of another worker's queue, where the most recently
+ submitted tasks are.
+ 
+ Tasks must not throw. An exception escaping a task ends the process, like
+ one escaping any thread function.
+ */
+class ThreadPool {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    
+public:
+    /**
+     Start the worker threads.
+     
+     @param threads The number of workers, `0` for one per hardware thread.
+     */
+    explicit ThreadPool(std::size_t threads = 0);
+    
+    /// Wait for all tasks and stop the workers
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    std::size_t size() const {
+        return _threads.size();
+    }
+    
+    /**
+     The index of the calling worker in its pool, `npos` when not called from
+     a worker thread.
+     */
+    static std::size_t currentIndex();
+    
+    /**
+     Add a task. Tasks are distributed to workers in turn.
+     */
+    void submit(std::function<void()> task);
+    
+    /**
+     Wait until all submitted tasks have run.
+     */
+    void wait();
+    
+    /// The number of tasks that were run by a worker other than the one they
+    /// were submitted to
+    std::size_t stolenCount() const {
+        return _stolen;
+    }
+    
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    
+    void run(std::size_t index);
+    bool take(std::size_t index, std::function<void()>& task);
+    bool dequeue(std::size_t index, std::function<void()>& task);
+    
+private:
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::size_t _nextQueue;
+    
+    std::mutex _mutex;
+    std::condition_variable _workAvailable;
+    std::condition_variable _idle;
+    std::size_t _pending;
+    std::size_t _queued;
+    std::atomic<std::size_t> _stolen;
+    bool _stopping;
+};
+
+} // namespace lxml
@@ -0,0 +1,43 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace lxml {
+
+/**
+ Wait on a condition variable until `predicate` returns `true`.
+ 
+ This is `std::condition_variable::wait` built on `wait_for`, which libstdc++
+ implements inline. Binaries then don't need the versioned `wait` symbol of
+ libstdc++ 12 and run against the older runtimes that often come with
+ libxml2 distributions.
+ */
+template <typename Predicate>
+void waitUntil(std::condition_variable& condition, std::unique_lock<std::mutex>& lock, Predicate predicate) {
+    while (!condition.wait_for(lock, std::chrono::seconds(1), predicate)) {
+    }
+}
+
+} // namespace lxml
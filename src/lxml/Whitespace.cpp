@@ -0,0 +1,140 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "Whitespace.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace lxml {
+
+#if defined(__SSE2__)
+
+// A 16-bit mask with a bit set for every whitespace byte in the block
+static inline unsigned spaceMask(const char* block) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    __m128i space = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\r'))));
+    return static_cast<unsigned>(_mm_movemask_epi8(space));
+}
+
+static const std::size_t kBlockSize = 16;
+static const unsigned kFullMask = 0xffff;
+
+#else
+
+// A SWAR version of the above for 8 bytes, with the high bit of each byte set
+// for whitespace
+static inline std::uint64_t matchBytes(std::uint64_t word, char c) {
+    const std::uint64_t ones = 0x0101010101010101ull;
+    const std::uint64_t highs = 0x8080808080808080ull;
+    std::uint64_t x = word ^ (ones * static_cast<unsigned char>(c));
+    return ~(((x & ~highs) + ~highs) | x) & highs;
+}
+
+static inline unsigned spaceMask(const char* block) {
+    std::uint64_t word;
+    std::memcpy(&word, block, sizeof(word));
+    std::uint64_t high = matchBytes(word, ' ') | matchBytes(word, '\t') | matchBytes(word, '\n') | matchBytes(word, '\r');
+
+    // Gather the high bits into the low byte, in memory order
+    unsigned mask = 0;
+    for (int i = 0; i < 8; i += 1) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        mask |= ((high >> (63 - 8 * i)) & 1) << i;
+#else
+        mask |= ((high >> (8 * i + 7)) & 1) << i;
+#endif
+    }
+    return mask;
+}
+
+static const std::size_t kBlockSize = 8;
+static const unsigned kFullMask = 0xff;
+
+#endif
+
+const char* findSpace(const char* first, const char* last) {
+    for (; static_cast<std::size_t>(last - first) >= kBlockSize; first += kBlockSize) {
+        unsigned mask = spaceMask(first);
+        if (mask)
+            return first + __builtin_ctz(mask);
+    }
+    while (first != last && !isXmlSpace(*first))
+        ++first;
+    return first;
+}
+
+const char* skipSpace(const char* first, const char* last) {
+    // Short runs of whitespace are the common case, check before loading blocks
+    if (first == last || !isXmlSpace(*first))
+        return first;
+
+    for (; static_cast<std::size_t>(last - first) >= kBlockSize; first += kBlockSize) {
+        unsigned mask = ~spaceMask(first) & kFullMask;
+        if (mask)
+            return first + __builtin_ctz(mask);
+    }
+    while (first != last && isXmlSpace(*first))
+        ++first;
+    return first;
+}
+
+const char* skipSpaceBackward(const char* first, const char* last) {
+    if (first == last || !isXmlSpace(*(last - 1)))
+        return last;
+
+    for (; static_cast<std::size_t>(last - first) >= kBlockSize; last -= kBlockSize) {
+        unsigned mask = ~spaceMask(last - kBlockSize) & kFullMask;
+        if (mask)
+            return last - kBlockSize + (32 - __builtin_clz(mask));
+    }
+    while (first != last && isXmlSpace(*(last - 1)))
+        --last;
+    return last;
+}
+
+std::size_t normalize(char* data, std::size_t length) {
+    const char* first = skipSpace(data, data + length);
+    const char* last = skipSpaceBackward(first, data + length);
+
+    // Copy each word down over the gap left by collapsed whitespace
+    char* output = data;
+    while (first != last) {
+        const char* end = findSpace(first, last);
+        if (output != first)
+            std::memmove(output, first, end - first);
+        output += end - first;
+        if (end == last)
+            break;
+
+        *output++ = ' ';
+        first = skipSpace(end, last);
+    }
+    return output - data;
+}
+
+} // namespace lxml
@@ -0,0 +1,77 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+namespace lxml {
+
+/**
+ Whether a character is XML whitespace: space, tab, line feed or carriage
+ return. Unlike `std::isspace` this does not depend on the locale.
+ */
+inline bool isXmlSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ Find the first whitespace character in a range, 16 bytes at a time where
+ SSE2 is available.
+ 
+ @return A pointer to the whitespace character or `last` if there is none.
+ */
+const char* findSpace(const char* first, const char* last);
+
+/**
+ Skip whitespace at the start of a range.
+ 
+ @return A pointer to the first non-whitespace character or `last` if there
+         is none.
+ */
+const char* skipSpace(const char* first, const char* last);
+
+/**
+ Skip whitespace at the end of a range.
+ 
+ @return A pointer past the last non-whitespace character or `first` if
+         there is none.
+ */
+const char* skipSpaceBackward(const char* first, const char* last);
+
+/**
+ Remove whitespace at the start and end of a string, without copying it.
+ */
+inline std::string_view trim(std::string_view string) {
+    const char* first = skipSpace(string.data(), string.data() + string.size());
+    const char* last = skipSpaceBackward(first, string.data() + string.size());
+    return std::string_view(first, last - first);
+}
+
+/**
+ Normalize whitespace in place: trim the string and replace every run of
+ whitespace inside it with a single space.
+ 
+ @return The normalized length.
+ */
+std::size_t normalize(char* data, std::size_t length);
+
+} // namespace lxml
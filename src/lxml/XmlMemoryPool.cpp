@@ -0,0 +1,511 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "XmlMemoryPool.h"
+
+#include <libxml/xmlmemory.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace lxml {
+
+namespace {
+
+// Slabs are aligned to their size so the slab of a block is found by
+// masking its address
+constexpr std::size_t kSlabShift = 16;
+constexpr std::size_t kSlabSize = std::size_t(1) << kSlabShift;
+constexpr std::size_t kSlabHeaderSize = 64;
+
+// Size classes step by a quarter of the previous power of two past 128
+constexpr std::size_t kClassCount = 32;
+constexpr std::array<std::uint32_t, kClassCount> kClassSizes = {{
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256,
+    320, 384, 448, 512,
+    640, 768, 896, 1024,
+    1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096,
+    5120, 6144, 7168, 8192
+}};
+static_assert(kClassSizes[kClassCount - 1] == XmlMemoryPool::kMaxPooledSize, "The last size class must be the largest pooled size");
+
+constexpr std::size_t kGranule = 16;
+constexpr std::size_t kLookupSize = XmlMemoryPool::kMaxPooledSize / kGranule + 1;
+
+constexpr std::array<std::uint8_t, kLookupSize> makeClassLookup() {
+    std::array<std::uint8_t, kLookupSize> lookup = {};
+    std::size_t sizeClass = 0;
+    for (std::size_t i = 0; i < kLookupSize; ++i) {
+        while (kClassSizes[sizeClass] < i * kGranule)
+            ++sizeClass;
+        lookup[i] = static_cast<std::uint8_t>(sizeClass);
+    }
+    return lookup;
+}
+
+constexpr std::array<std::uint8_t, kLookupSize> kClassLookup = makeClassLookup();
+
+inline std::size_t classOf(std::size_t size) {
+    return kClassLookup[(size + kGranule - 1) / kGranule];
+}
+
+inline std::size_t blocksPerSlab(std::size_t sizeClass) {
+    return (kSlabSize - kSlabHeaderSize) / kClassSizes[sizeClass];
+}
+
+// A thread keeps at most two slabs' worth of free blocks per class before
+// giving half of them to the depot
+inline std::size_t cacheLimit(std::size_t sizeClass) {
+    std::size_t limit = 2 * blocksPerSlab(sizeClass);
+    return limit < 16 ? 16 : limit;
+}
+
+// What refilling a thread takes from the depot at once
+inline std::size_t refillBatch(std::size_t sizeClass) {
+    std::size_t batch = blocksPerSlab(sizeClass) / 2;
+    return batch < 1 ? 1 : batch;
+}
+
+struct Slab {
+    Slab* next;
+    std::uint32_t sizeClass;
+};
+static_assert(sizeof(Slab) <= kSlabHeaderSize, "The slab header must fit in front of the blocks");
+
+inline Slab* slabOf(const void* pointer) {
+    return reinterpret_cast<Slab*>(reinterpret_cast<std::uintptr_t>(pointer) & ~(kSlabSize - 1));
+}
+
+struct Block {
+    Block* next;
+};
+
+struct FreeList {
+    Block* head;
+    std::size_t count;
+    
+    void push(Block* block) {
+        block->next = head;
+        head = block;
+        ++count;
+    }
+    
+    Block* pop() {
+        Block* block = head;
+        head = block->next;
+        --count;
+        return block;
+    }
+    
+    /**
+     Move up to `count` blocks to another list.
+     */
+    std::size_t moveTo(FreeList& other, std::size_t count) {
+        if (count > this->count)
+            count = this->count;
+        if (count == 0)
+            return 0;
+        
+        Block* last = head;
+        for (std::size_t i = 1; i < count; ++i)
+            last = last->next;
+        Block* first = head;
+        head = last->next;
+        this->count -= count;
+        
+        last->next = other.head;
+        other.head = first;
+        other.count += count;
+        return count;
+    }
+};
+
+
+// Which 64 KB pages of the address space are slabs, one bit per page in
+// leaves created on demand. This is what tells pooled blocks from memory
+// that came from malloc. Addresses past 47 bits are never pooled.
+constexpr std::size_t kLeafBits = 16;
+constexpr std::size_t kLeafWords = (std::size_t(1) << kLeafBits) / 64;
+constexpr std::size_t kRootSize = std::size_t(1) << (47 - kSlabShift - kLeafBits);
+
+typedef std::atomic<std::uint64_t> SlabMapWord;
+std::atomic<SlabMapWord*> __slab_map[kRootSize];
+
+bool markSlab(const void* slab) {
+    std::uintptr_t page = reinterpret_cast<std::uintptr_t>(slab) >> kSlabShift;
+    std::uintptr_t root = page >> kLeafBits;
+    if (root >= kRootSize)
+        return false;
+    
+    SlabMapWord* leaf = __slab_map[root].load(std::memory_order_acquire);
+    if (!leaf) {
+        SlabMapWord* created = new SlabMapWord[kLeafWords]();
+        if (__slab_map[root].compare_exchange_strong(leaf, created, std::memory_order_acq_rel))
+            leaf = created;
+        else
+            delete[] created;
+    }
+    
+    std::uintptr_t bit = page & ((std::uintptr_t(1) << kLeafBits) - 1);
+    leaf[bit / 64].fetch_or(std::uint64_t(1) << (bit % 64), std::memory_order_release);
+    return true;
+}
+
+inline bool isPooled(const void* pointer) {
+    std::uintptr_t page = reinterpret_cast<std::uintptr_t>(pointer) >> kSlabShift;
+    std::uintptr_t root = page >> kLeafBits;
+    if (root >= kRootSize)
+        return false;
+    
+    const SlabMapWord* leaf = __slab_map[root].load(std::memory_order_acquire);
+    if (!leaf)
+        return false;
+    std::uintptr_t bit = page & ((std::uintptr_t(1) << kLeafBits) - 1);
+    return (leaf[bit / 64].load(std::memory_order_relaxed) >> (bit % 64)) & 1;
+}
+
+
+/**
+ A counter written only by its own thread and read by any, without locked
+ instructions on the write side.
+ */
+template <typename T>
+class Counter {
+public:
+    Counter() : _value(0) {}
+    
+    void add(T value) {
+        _value.store(_value.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+    
+    T get() const {
+        return _value.load(std::memory_order_relaxed);
+    }
+    
+private:
+    std::atomic<T> _value;
+};
+
+struct Counters {
+    Counter<std::uint64_t> allocations;
+    Counter<std::uint64_t> frees;
+    Counter<std::uint64_t> reallocations;
+    Counter<std::uint64_t> largeAllocations;
+    Counter<std::int64_t> bytesInUse;
+    
+    void addTo(XmlMemoryStats& stats) const {
+        stats.allocations += allocations.get();
+        stats.frees += frees.get();
+        stats.reallocations += reallocations.get();
+        stats.largeAllocations += largeAllocations.get();
+        stats.bytesInUse += bytesInUse.get();
+    }
+};
+
+struct ThreadCache {
+    ThreadCache() : lists(), previous(), next() {}
+    
+    FreeList lists[kClassCount];
+    Counters counters;
+    ThreadCache* previous;
+    ThreadCache* next;
+};
+
+
+/**
+ Blocks shared between threads, the registry of thread caches and the
+ counters of threads that exited. It is never destroyed, because libxml2
+ frees memory during static destruction.
+ */
+struct Depot {
+    Depot() : lists(), slabs(), caches(), reservedBytes(0) {}
+    
+    std::mutex mutex;
+    FreeList lists[kClassCount];
+    Slab* slabs;
+    ThreadCache* caches;
+    XmlMemoryStats retired;
+    std::atomic<std::uint64_t> reservedBytes;
+};
+
+Depot& depot() {
+    static Depot* depot = new Depot;
+    return *depot;
+}
+
+/**
+ Carve a new slab into `list`.
+ */
+bool addSlab(std::size_t sizeClass, FreeList& list) {
+    void* memory = std::aligned_alloc(kSlabSize, kSlabSize);
+    if (!memory)
+        return false;
+    if (!markSlab(memory)) {
+        std::free(memory);
+        return false;
+    }
+    
+    Depot& shared = depot();
+    Slab* slab = static_cast<Slab*>(memory);
+    slab->sizeClass = static_cast<std::uint32_t>(sizeClass);
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        slab->next = shared.slabs;
+        shared.slabs = slab;
+    }
+    shared.reservedBytes.fetch_add(kSlabSize, std::memory_order_relaxed);
+    
+    // Push in reverse so blocks are handed out in address order
+    std::size_t blockSize = kClassSizes[sizeClass];
+    char* blocks = static_cast<char*>(memory) + kSlabHeaderSize;
+    for (std::size_t i = blocksPerSlab(sizeClass); i > 0; --i)
+        list.push(reinterpret_cast<Block*>(blocks + (i - 1) * blockSize));
+    return true;
+}
+
+bool refill(std::size_t sizeClass, FreeList& list) {
+    Depot& shared = depot();
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (shared.lists[sizeClass].moveTo(list, refillBatch(sizeClass)) > 0)
+            return true;
+    }
+    return addSlab(sizeClass, list);
+}
+
+
+/**
+ Owns the calling thread's cache. When the thread exits its blocks and
+ counters go to the depot.
+ */
+class CacheOwner {
+public:
+    CacheOwner();
+    ~CacheOwner();
+    
+    ThreadCache cache;
+};
+
+// Set to kDeadCache once the owner is destroyed, libxml2 may still free
+// memory later in the thread's exit
+thread_local ThreadCache* __thread_cache = 0;
+ThreadCache* const kDeadCache = reinterpret_cast<ThreadCache*>(std::uintptr_t(1));
+
+CacheOwner::CacheOwner() {
+    Depot& shared = depot();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    cache.next = shared.caches;
+    if (shared.caches)
+        shared.caches->previous = &cache;
+    shared.caches = &cache;
+}
+
+CacheOwner::~CacheOwner() {
+    Depot& shared = depot();
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (std::size_t i = 0; i < kClassCount; ++i)
+            cache.lists[i].moveTo(shared.lists[i], cache.lists[i].count);
+        cache.counters.addTo(shared.retired);
+        
+        if (cache.previous)
+            cache.previous->next = cache.next;
+        else
+            shared.caches = cache.next;
+        if (cache.next)
+            cache.next->previous = cache.previous;
+    }
+    __thread_cache = kDeadCache;
+}
+
+/**
+ The calling thread's cache, `0` while the thread is exiting.
+ */
+inline ThreadCache* localCache() {
+    ThreadCache* cache = __thread_cache;
+    if (cache)
+        return cache == kDeadCache ? 0 : cache;
+    
+    static thread_local CacheOwner owner;
+    __thread_cache = &owner.cache;
+    return &owner.cache;
+}
+
+/**
+ Allocate and free through the depot, for threads without a cache.
+ */
+void* allocateShared(std::size_t sizeClass) {
+    Depot& shared = depot();
+    FreeList& list = shared.lists[sizeClass];
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (list.head) {
+            shared.retired.allocations += 1;
+            shared.retired.bytesInUse += kClassSizes[sizeClass];
+            return list.pop();
+        }
+    }
+    
+    FreeList slab = {};
+    if (!addSlab(sizeClass, slab))
+        return 0;
+    Block* block = slab.pop();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    slab.moveTo(list, slab.count);
+    shared.retired.allocations += 1;
+    shared.retired.bytesInUse += kClassSizes[sizeClass];
+    return block;
+}
+
+void freeShared(Block* block, std::size_t sizeClass) {
+    Depot& shared = depot();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.lists[sizeClass].push(block);
+    shared.retired.frees += 1;
+    shared.retired.bytesInUse -= kClassSizes[sizeClass];
+}
+
+void* allocateLarge(std::size_t size) {
+    if (ThreadCache* cache = localCache()) {
+        cache->counters.allocations.add(1);
+        cache->counters.largeAllocations.add(1);
+    }
+    return std::malloc(size);
+}
+
+std::atomic<bool> __installed(false);
+
+} // namespace
+
+
+void* XmlMemoryPool::allocate(std::size_t size) {
+    if (size > kMaxPooledSize)
+        return allocateLarge(size);
+    
+    std::size_t sizeClass = classOf(size);
+    ThreadCache* cache = localCache();
+    if (!cache) {
+        if (void* block = allocateShared(sizeClass))
+            return block;
+        return std::malloc(size);
+    }
+    
+    FreeList& list = cache->lists[sizeClass];
+    if (!list.head && !refill(sizeClass, list))
+        return allocateLarge(size);
+    
+    cache->counters.allocations.add(1);
+    cache->counters.bytesInUse.add(kClassSizes[sizeClass]);
+    return list.pop();
+}
+
+void XmlMemoryPool::free(void* pointer) {
+    if (!pointer)
+        return;
+    
+    if (!isPooled(pointer)) {
+        if (ThreadCache* cache = localCache())
+            cache->counters.frees.add(1);
+        std::free(pointer);
+        return;
+    }
+    
+    std::size_t sizeClass = slabOf(pointer)->sizeClass;
+    Block* block = static_cast<Block*>(pointer);
+    ThreadCache* cache = localCache();
+    if (!cache) {
+        freeShared(block, sizeClass);
+        return;
+    }
+    
+    cache->counters.frees.add(1);
+    cache->counters.bytesInUse.add(-static_cast<std::int64_t>(kClassSizes[sizeClass]));
+    FreeList& list = cache->lists[sizeClass];
+    list.push(block);
+    if (list.count > cacheLimit(sizeClass)) {
+        Depot& shared = depot();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        list.moveTo(shared.lists[sizeClass], list.count / 2);
+    }
+}
+
+void* XmlMemoryPool::reallocate(void* pointer, std::size_t size) {
+    if (ThreadCache* cache = localCache())
+        cache->counters.reallocations.add(1);
+    if (!pointer)
+        return allocate(size);
+    
+    // Blocks from malloc stay with malloc
+    if (!isPooled(pointer))
+        return std::realloc(pointer, size);
+    
+    std::size_t blockSize = kClassSizes[slabOf(pointer)->sizeClass];
+    if (size <= blockSize)
+        return pointer;
+    
+    void* moved = allocate(size);
+    if (!moved)
+        return 0;
+    std::memcpy(moved, pointer, blockSize);
+    free(pointer);
+    return moved;
+}
+
+char* XmlMemoryPool::duplicate(const char* string) {
+    std::size_t size = std::strlen(string) + 1;
+    char* copy = static_cast<char*>(allocate(size));
+    if (copy)
+        std::memcpy(copy, string, size);
+    return copy;
+}
+
+bool XmlMemoryPool::install() {
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (__installed.load())
+        return true;
+    
+    if (xmlGcMemSetup(&XmlMemoryPool::free, &XmlMemoryPool::allocate, &XmlMemoryPool::allocate, &XmlMemoryPool::reallocate, &XmlMemoryPool::duplicate) != 0)
+        return false;
+    __installed.store(true);
+    return true;
+}
+
+bool XmlMemoryPool::installed() {
+    return __installed.load();
+}
+
+XmlMemoryStats XmlMemoryPool::stats() {
+    Depot& shared = depot();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    XmlMemoryStats stats = shared.retired;
+    for (ThreadCache* cache = shared.caches; cache; cache = cache->next)
+        cache->counters.addTo(stats);
+    stats.reservedBytes = shared.reservedBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace lxml
@@ -0,0 +1,108 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace lxml {
+
+/**
+ Counters for the memory that libxml2 allocated through XmlMemoryPool, over
+ all threads since the pool was installed.
+ */
+struct XmlMemoryStats {
+    XmlMemoryStats()
+    : allocations(), frees(), reallocations(), largeAllocations(), bytesInUse(), reservedBytes() {}
+    
+    /// Blocks handed out, including those too large for the pool
+    std::uint64_t allocations;
+    
+    /// Blocks given back
+    std::uint64_t frees;
+    
+    /// Calls to realloc, whether or not the block moved
+    std::uint64_t reallocations;
+    
+    /// Blocks too large for the size classes, which come from malloc
+    std::uint64_t largeAllocations;
+    
+    /// Bytes of pooled blocks currently handed out, rounded up to their
+    /// size class
+    std::int64_t bytesInUse;
+    
+    /// Bytes of slabs taken from the system. Slabs are never returned, so
+    /// this is the high water mark of pooled memory.
+    std::uint64_t reservedBytes;
+};
+
+/**
+ XmlMemoryPool serves libxml2's own allocations, such as input buffers,
+ name stacks, node info and dictionary entries, from size-class pools
+ instead of malloc.
+ 
+ Each thread keeps free lists per size class, so a parse reuses the blocks
+ the previous document on the same thread gave back, without locking and
+ without spreading small blocks over glibc's arenas. Blocks are carved from
+ 64 KB slabs. Free lists that grow too long, and those of threads that exit,
+ go back to a shared depot that other threads refill from.
+ 
+ The hooks are process-wide, installed through `xmlGcMemSetup` (which also
+ covers `xmlMemSetup`'s functions). Whether a block belongs to the pool is
+ decided by its address, so memory libxml2 allocated before the pool was
+ installed, and blocks too large for the pool, are still handled by malloc
+ and free. That makes it safe to install at any time, but the pool can't
+ be uninstalled, and nothing else may replace libxml2's allocator
+ afterwards while pooled blocks are alive.
+ */
+class XmlMemoryPool {
+public:
+    /// The largest request served from the pool
+    static constexpr std::size_t kMaxPooledSize = 8192;
+    
+public:
+    /**
+     Route libxml2's allocations through the pool. Installing twice is
+     harmless.
+     
+     @return `false` if libxml2's allocator can't be changed.
+     */
+    static bool install();
+    
+    static bool installed();
+    
+    /**
+     Counters over all threads. Threads update their own counters without
+     synchronization, so a snapshot taken while parsing is approximate.
+     */
+    static XmlMemoryStats stats();
+    
+    /**
+     The hooks installed into libxml2. They can be used directly, for
+     instance by an allocator that wraps them to count calls.
+     */
+    static void* allocate(std::size_t size);
+    static void* reallocate(void* pointer, std::size_t size);
+    static void free(void* pointer);
+    static char* duplicate(const char* string);
+};
+
+} // namespace lxml
@@ -0,0 +1,272 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include "XmlReader.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace lxml {
+
+// Events are recorded one chunk of input at a time
+static const std::size_t kChunkSize = 16*1024;
+
+static const std::size_t kAttributeStride = 5;
+
+XmlReader::XmlReader() : _data(), _length(), _stream(), _next(), _current(), _event(), _depth(), _open(), _recordDepth(), _skipDepth(), _skipping(), _active(), _failed() {
+    _recorder.reader = this;
+}
+
+XmlReader::XmlReader(const ParseOptions& options) : _parser(options), _data(), _length(), _stream(), _next(), _current(), _event(), _depth(), _open(), _recordDepth(), _skipDepth(), _skipping(), _active(), _failed() {
+    _recorder.reader = this;
+}
+
+bool XmlReader::open(const char* data, std::size_t length, const std::string& filename) {
+    _data = data;
+    _length = length;
+    _stream = 0;
+    return start(filename);
+}
+
+bool XmlReader::open(std::istream& is, const std::string& filename) {
+    _data = 0;
+    _length = 0;
+    _stream = &is;
+    _chunk.resize(kChunkSize);
+    return start(filename);
+}
+
+bool XmlReader::openFile(const std::string& path) {
+    if (!_file.open(path)) {
+        _active = false;
+        _failed = true;
+        return false;
+    }
+    return open(_file.data(), _file.size(), path);
+}
+
+bool XmlReader::start(const std::string& filename) {
+    _events.clear();
+    _attributes.clear();
+    _chars.clear();
+    _next = 0;
+    _current = 0;
+    _event = XmlEvent::None;
+    _depth = 0;
+    _open = 0;
+    _recordDepth = 0;
+    _skipDepth = 0;
+    _skipping = false;
+    
+    ParseContext::Scope scope(_parser._parseContext);
+    _active = _parser.begin(filename, StaticSAXHandler<Recorder>::table(), &_recorder);
+    _failed = !_active;
+    return _active;
+}
+
+bool XmlReader::read() {
+    if (_next == _events.size() && !fill()) {
+        _event = XmlEvent::None;
+        return false;
+    }
+    
+    _current = _next++;
+    _event = _events[_current].type;
+    switch (_event) {
+        case XmlEvent::StartElement:
+            _depth = _open++;
+            break;
+        case XmlEvent::EndElement:
+            _depth = --_open;
+            break;
+        default:
+            _depth = _open;
+            break;
+    }
+    return true;
+}
+
+bool XmlReader::skipSubtree() {
+    if (_event != XmlEvent::StartElement)
+        return false;
+    
+    // The end may already be buffered
+    std::size_t open = 0;
+    for (std::size_t i = _next; i < _events.size(); ++i) {
+        if (_events[i].type == XmlEvent::StartElement) {
+            ++open;
+        } else if (_events[i].type == XmlEvent::EndElement) {
+            if (open == 0) {
+                _next = i;
+                return read();
+            }
+            --open;
+        }
+    }
+    
+    // Everything buffered is inside the element, drop it and don't record
+    // anything until the element ends
+    _next = _events.size();
+    _skipping = true;
+    _skipDepth = _depth;
+    return read();
+}
+
+bool XmlReader::readElementText(std::string_view& text) {
+    if (_event != XmlEvent::StartElement)
+        return false;
+    
+    // Leaf elements with their end buffered don't need a copy
+    if (_next < _events.size() && _events[_next].type == XmlEvent::EndElement) {
+        text = std::string_view();
+        return read();
+    }
+    if (_next + 1 < _events.size() && _events[_next].type == XmlEvent::Text && _events[_next + 1].type == XmlEvent::EndElement) {
+        const Event& event = _events[_next];
+        text = std::string_view(_chars.data() + event.first, event.count);
+        ++_next;
+        return read();
+    }
+    
+    std::size_t depth = _depth;
+    _text.clear();
+    while (read()) {
+        if (_event == XmlEvent::Text) {
+            _text.append(this->text());
+        } else if (_event == XmlEvent::EndElement && _depth == depth) {
+            text = _text;
+            return true;
+        }
+    }
+    return false;
+}
+
+AttributeView XmlReader::attributes() const {
+    if (_event != XmlEvent::StartElement)
+        return AttributeView();
+    
+    const Event& event = _events[_current];
+    return AttributeView(const_cast<const xmlChar**>(_attributes.data()) + event.first, static_cast<int>(event.count), _parser.options().symbols);
+}
+
+std::string_view XmlReader::text() const {
+    if (_event != XmlEvent::Text)
+        return std::string_view();
+    
+    const Event& event = _events[_current];
+    return std::string_view(_chars.data() + event.first, event.count);
+}
+
+bool XmlReader::fill() {
+    _events.clear();
+    _attributes.clear();
+    _chars.clear();
+    _next = 0;
+    
+    while (_events.empty() && _active)
+        feedChunk();
+    
+    resolveAttributes();
+    return !_events.empty();
+}
+
+bool XmlReader::feedChunk() {
+    ParseContext::Scope scope(_parser._parseContext);
+    
+    bool result = true;
+    if (_stream && *_stream) {
+        _stream->read(_chunk.data(), static_cast<std::streamsize>(_chunk.size()));
+        result = _parser.feed(_chunk.data(), static_cast<std::size_t>(_stream->gcount()));
+    } else if (!_stream && _length > 0) {
+        std::size_t size = std::min(_length, kChunkSize);
+        result = _parser.feed(_data, size);
+        _data += size;
+        _length -= size;
+    } else {
+        result = _parser.finish();
+        _active = false;
+    }
+    
+    if (!result) {
+        _active = false;
+        _failed = true;
+    }
+    return result;
+}
+
+void XmlReader::resolveAttributes() {
+    // Values are recorded as offsets because the text buffer may grow
+    const xmlChar* base = reinterpret_cast<const xmlChar*>(_chars.data());
+    for (std::size_t i = 0; i < _attributes.size(); i += kAttributeStride) {
+        _attributes[i + 3] = base + reinterpret_cast<std::uintptr_t>(_attributes[i + 3]);
+        _attributes[i + 4] = base + reinterpret_cast<std::uintptr_t>(_attributes[i + 4]);
+    }
+}
+
+void XmlReader::Recorder::startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+    XmlReader& r = *reader;
+    ++r._recordDepth;
+    if (r._skipping) {
+        ParseContext::current()->skipSubtree();
+        return;
+    }
+    
+    r._events.push_back(Event{XmlEvent::StartElement, qname, r._attributes.size(), attributes.size()});
+    for (Attribute attribute : attributes) {
+        std::string_view value = attribute.value();
+        std::uintptr_t offset = r._chars.size();
+        r._chars.append(value);
+        
+        r._attributes.push_back(reinterpret_cast<const xmlChar*>(attribute.localName()));
+        r._attributes.push_back(reinterpret_cast<const xmlChar*>(attribute.prefix()));
+        r._attributes.push_back(reinterpret_cast<const xmlChar*>(attribute.namespaceURI()));
+        r._attributes.push_back(reinterpret_cast<const xmlChar*>(offset));
+        r._attributes.push_back(reinterpret_cast<const xmlChar*>(offset + value.size()));
+    }
+}
+
+void XmlReader::Recorder::endElement(const QName& qname) {
+    XmlReader& r = *reader;
+    --r._recordDepth;
+    if (r._skipping) {
+        if (r._recordDepth != r._skipDepth)
+            return;
+        r._skipping = false;
+    }
+    
+    r._events.push_back(Event{XmlEvent::EndElement, qname, 0, 0});
+}
+
+void XmlReader::Recorder::characters(const char* chars, std::size_t length) {
+    XmlReader& r = *reader;
+    if (r._skipping)
+        return;
+    
+    // libxml2 delivers text in pieces, join the ones that follow each other
+    if (!r._events.empty() && r._events.back().type == XmlEvent::Text) {
+        r._events.back().count += length;
+    } else {
+        r._events.push_back(Event{XmlEvent::Text, QName(), r._chars.size(), length});
+    }
+    r._chars.append(chars, length);
+}
+
+} // namespace lxml
@@ -0,0 +1,203 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+#include "AttributeView.h"
+#include "MappedFile.h"
+#include "Parser.h"
+#include "QName.h"
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lxml {
+
+enum class XmlEvent {
+    None,
+    StartElement,
+    EndElement,
+    Text
+};
+
+/**
+ XmlReader is a pull parser: the caller asks for one event at a time with
+ `read()` instead of receiving callbacks.
+ 
+ It runs on the same push context as Parser. Each time its buffered events
+ run out it hands libxml2 the next chunk of input and records the events
+ that chunk produces into reusable buffers, so memory is bounded by the
+ chunk size and no allocation happens per event once the buffers have
+ grown. Names point to the parser's dictionary; attribute values and text
+ are copied into the buffers.
+ 
+ Names, attributes and text are valid until the next call that moves the
+ reader. Text between two tags may be split into several events.
+ */
+class XmlReader {
+public:
+    XmlReader();
+    explicit XmlReader(const ParseOptions& options);
+    
+    XmlReader(const XmlReader&) = delete;
+    XmlReader& operator=(const XmlReader&) = delete;
+    
+    /**
+     Start reading a document in memory. The data must outlive the reader
+     or the next call to `open`.
+     */
+    bool open(const char* data, std::size_t length, const std::string& filename);
+    
+    /**
+     Start reading a stream. The stream must outlive the reader or the next
+     call to `open`.
+     */
+    bool open(std::istream& is, const std::string& filename);
+    
+    /**
+     Start reading a memory mapped file.
+     */
+    bool openFile(const std::string& path);
+    
+    /**
+     Move to the next event.
+     
+     @return `false` at the end of the document or after an error.
+     */
+    bool read();
+    
+    /**
+     Skip the rest of the element whose start is the current event and
+     move to its end event. Its contents are not buffered; if they haven't
+     been parsed yet libxml2 skips them without calling back.
+     
+     @return `false` if the current event is not a start element or there
+             is an error.
+     */
+    bool skipSubtree();
+    
+    /**
+     Read the text of the element whose start is the current event,
+     including the text of its descendants, and move to its end event.
+     
+     @return `false` if the current event is not a start element or there
+             is an error.
+     */
+    bool readElementText(std::string_view& text);
+    
+    XmlEvent event() const {
+        return _event;
+    }
+    
+    /**
+     The name of the current start or end element.
+     */
+    const QName& name() const {
+        return _events[_current].name;
+    }
+    
+    /**
+     The attributes of the current start element.
+     */
+    AttributeView attributes() const;
+    
+    /**
+     The current text.
+     */
+    std::string_view text() const;
+    
+    /**
+     The number of elements enclosing the current event, not counting the
+     current element.
+     */
+    std::size_t depth() const {
+        return _depth;
+    }
+    
+    /**
+     Whether the document had an error.
+     */
+    bool failed() const {
+        return _failed;
+    }
+    
+private:
+    struct Event {
+        XmlEvent type;
+        QName name;
+        
+        /// The attribute or text range in the buffers
+        std::size_t first;
+        std::size_t count;
+    };
+    
+    /**
+     The statically dispatched handler that records events.
+     */
+    struct Recorder {
+        XmlReader* reader;
+        
+        void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes);
+        void endElement(const QName& qname);
+        void characters(const char* chars, std::size_t length);
+    };
+    
+    bool start(const std::string& filename);
+    bool fill();
+    bool feedChunk();
+    void resolveAttributes();
+    
+private:
+    Parser _parser;
+    Recorder _recorder;
+    MappedFile _file;
+    
+    /// Input left to feed
+    const char* _data;
+    std::size_t _length;
+    std::istream* _stream;
+    std::vector<char> _chunk;
+    
+    /// Recorded events, attributes and text
+    std::vector<Event> _events;
+    std::vector<const xmlChar*> _attributes;
+    std::string _chars;
+    
+    std::size_t _next;
+    std::size_t _current;
+    XmlEvent _event;
+    std::size_t _depth;
+    std::size_t _open;
+    
+    /// Open elements as seen by the recorder, and while skipping the depth
+    /// at which recording resumes
+    std::size_t _recordDepth;
+    std::size_t _skipDepth;
+    bool _skipping;
+    
+    std::string _text;
+    bool _active;
+    bool _failed;
+};
+
+} // namespace lxml
@@ -19,9 +19,17 @@
 // DEALINGS IN THE SOFTWARE.
 
 #pragma once
+#include "MapSAXHandler.h"
+#include "ParseOptions.h"
+#include "Parser.h"
+#include "ParserPool.h"
+#include "ParseStatus.h"
 #include "SAXHandler.h"
 #include "RootRecursiveHandler.h"
+#include "SymbolTable.h"
+#include "XmlMemoryPool.h"
 
+#include <cstddef>
 #include <istream>
 #include <string>
 
@@ -42,6 +50,9 @@
  improves the modularity, maintainability and reusability of the code. Each
  handler recursively specifies sub-handlers to deal with sub-elements. See
  [RecursiveHandler](@ref lxml::RecursiveHandler) for more information.
+ 
+ To parse many documents, keep a [Parser](@ref lxml::Parser) around. It
+ reuses its libxml2 context between documents.
  */
 
 namespace lxml {
@@ -52,12 +63,14 @@ namespace lxml {
  @param is       The input stream with XML data.
  @param filename The filename to use when generating error messages.
  @param handler  The SAX event handler.
+ @param options  Optional parse settings.
+ @param status   If not null, set to how the parse ended, see ParseStatus.
  
  @return `true` if parsing is successful, `false` if there is an error
          parsing.
  */
 
-bool parse(std::istream& is, const std::string& filename, SAXHandler& handler);
+bool parse(std::istream& is, const std::string& filename, SAXHandler& handler, const ParseOptions& options = ParseOptions(), ParseStatus* status = 0);
 
 /**
  Parse an XML stream delivering SAX events recursively to handlers.
@@ -65,10 +78,125 @@ bool parse(std::istream& is, const std::string& filename, SAXHandler& handler);
  @param is       The input stream with XML data.
  @param filename The filename to use when generating error messages.
  @param handler  The recursive SAX event handler.
+ @param options  Optional parse settings.
+ @param status   If not null, set to how the parse ended, see ParseStatus.
 
  @return `true` if parsing is successful, `false` if there is an error
  parsing.
  */
-bool parse(std::istream& is, const std::string& filename, RecursiveHandler& handler);
+bool parse(std::istream& is, const std::string& filename, RecursiveHandler& handler, const ParseOptions& options = ParseOptions(), ParseStatus* status = 0);
+
+/**
+ Parse an XML document in memory delivering SAX events to a handler. The
+ buffer is handed to libxml2 directly, without an intermediate copy.
+
+ @param data     The XML data.
+ @param length   The length of the XML data in bytes.
+ @param filename The filename to use when generating error messages.
+ @param handler  The SAX event handler.
+ @param options  Optional parse settings.
+ @param status   If not null, set to how the parse ended, see ParseStatus.
+
+ @return `true` if parsing is successful, `false` if there is an error
+         parsing.
+ */
+bool parse(const char* data, std::size_t length, const std::string& filename, SAXHandler& handler, const ParseOptions& options = ParseOptions(), ParseStatus* status = 0);
+
+/**
+ Parse an XML document in memory delivering SAX events recursively to
+ handlers.
+
+ @param data     The XML data.
+ @param length   The length of the XML data in bytes.
+ @param filename The filename to use when generating error messages.
+ @param handler  The recursive SAX event handler.
+ @param options  Optional parse settings.
+ @param status   If not null, set to how the parse ended, see ParseStatus.
+
+ @return `true` if parsing is successful, `false` if there is an error
+         parsing.
+ */
+bool parse(const char* data, std::size_t length, const std::string& filename, RecursiveHandler& handler, const ParseOptions& options = ParseOptions(), ParseStatus* status = 0);
+
+/**
+ Parse an XML file delivering SAX events to a handler. The file is memory
+ mapped and fed to libxml2 in large sequential regions.
+
+ @param path    The path of the XML file.
+ @param handler The SAX event handler.
+ @param options Optional parse settings.
+ @param status  If not null, set to how the parse ended, see ParseStatus.
+
+ @return `true` if parsing is successful, `false` if the file can't be
+         opened or there is an error parsing.
+ */
+bool parseFile(const std::string& path, SAXHandler& handler, const ParseOptions& options = ParseOptions(), ParseStatus* status = 0);
+
+/**
+ Parse an XML file delivering SAX events recursively to handlers. The file
+ is memory mapped and fed to libxml2 in large sequential regions.
+
+ @param path    The path of the XML file.
+ @param handler The recursive SAX event handler.
+ @param options Optional parse settings.
+ @param status  If not null, set to how the parse ended, see ParseStatus.
+
+ @return `true` if parsing is successful, `false` if the file can't be
+         opened or there is an error parsing.
+ */
+bool parseFile(const std::string& path, RecursiveHandler& handler, const ParseOptions& options = ParseOptions(), ParseStatus* status = 0);
+
+/**
+ Parse an XML stream delivering SAX events to a handler with statically
+ dispatched callbacks. The handler is any class that is not a SAXHandler or
+ RecursiveHandler and implements some of the SAXHandler methods, see
+ isStaticHandler. Its methods are called directly instead of virtually and
+ events it does not implement are not registered with libxml2. Like the
+ other parse functions, it sets `status` to how the parse ended if it is
+ not null.
+
+ @return `true` if parsing is successful, `false` if there is an error
+         parsing.
+ */
+template <typename Handler, typename = std::enable_if_t<isStaticHandler<Handler>>>
+bool parse(std::istream& is, const std::string& filename, Handler& handler, const ParseOptions& options = ParseOptions(), ParseStatus* status = 0) {
+    Parser parser(options);
+    bool result = parser.parse(is, filename, handler);
+    if (status)
+        *status = parser.status();
+    return result;
+}
+
+/**
+ Parse an XML document in memory delivering SAX events to a handler with
+ statically dispatched callbacks.
+
+ @return `true` if parsing is successful, `false` if there is an error
+         parsing.
+ */
+template <typename Handler, typename = std::enable_if_t<isStaticHandler<Handler>>>
+bool parse(const char* data, std::size_t length, const std::string& filename, Handler& handler, const ParseOptions& options = ParseOptions(), ParseStatus* status = 0) {
+    Parser parser(options);
+    bool result = parser.parse(data, length, filename, handler);
+    if (status)
+        *status = parser.status();
+    return result;
+}
+
+/**
+ Parse a memory mapped XML file delivering SAX events to a handler with
+ statically dispatched callbacks.
+
+ @return `true` if parsing is successful, `false` if the file can't be
+         opened or there is an error parsing.
+ */
+template <typename Handler, typename = std::enable_if_t<isStaticHandler<Handler>>>
+bool parseFile(const std::string& path, Handler& handler, const ParseOptions& options = ParseOptions(), ParseStatus* status = 0) {
+    Parser parser(options);
+    bool result = parser.parseFile(path, handler);
+    if (status)
+        *status = parser.status();
+    return result;
+}
 
 }
@@ -0,0 +1,106 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/BaseRecursiveHandler.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+using namespace lxml;
+
+static const char* kWordsXML = "<words><word>alpha</word><word>beta</word><word>gamma</word></words>";
+
+/**
+ A handler that copies words into memory allocated from the parse context.
+ */
+class WordsHandler : public BaseRecursiveHandler<std::vector<std::string_view>> {
+public:
+    bool arena;
+    
+public:
+    WordsHandler() : arena() {}
+    
+    void startElement(const QName& qname, const AttributeView& attributes) {
+        arena = ParseContext::current()->hasArena();
+        _result.clear();
+    }
+    
+    RecursiveHandler* startSubElement(const QName& qname) {
+        return &_wordHandler;
+    }
+    
+    void endSubElement(const QName& qname, RecursiveHandler* handler) {
+        _result.push_back(_wordHandler.result());
+    }
+    
+private:
+    class WordHandler : public BaseRecursiveHandler<std::string_view> {
+    public:
+        void endElement(const QName& qname, std::string_view contents) {
+            std::pmr::memory_resource* resource = ParseContext::current()->resource();
+            char* word = static_cast<char*>(resource->allocate(contents.size(), 1));
+            std::memcpy(word, contents.data(), contents.size());
+            _result = std::string_view(word, contents.size());
+        }
+    };
+    
+    WordHandler _wordHandler;
+};
+
+
+BOOST_AUTO_TEST_CASE(arenaTest) {
+    BOOST_CHECK(ParseContext::current() == 0);
+    
+    ParseOptions options;
+    options.useArena = true;
+    Parser parser(options);
+    
+    WordsHandler handler;
+    for (int i = 0; i < 3; i += 1) {
+        BOOST_CHECK(parser.parse(kWordsXML, std::strlen(kWordsXML), "words", handler));
+        BOOST_CHECK(handler.arena);
+        
+        // Arena memory stays valid until the next document starts
+        const std::vector<std::string_view>& words = handler.result();
+        BOOST_REQUIRE_EQUAL(words.size(), 3);
+        BOOST_CHECK_EQUAL(words[0], "alpha");
+        BOOST_CHECK_EQUAL(words[2], "gamma");
+    }
+    
+    BOOST_CHECK(ParseContext::current() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(defaultResourceTest) {
+    Parser parser;
+    
+    WordsHandler handler;
+    BOOST_CHECK(parser.parse(kWordsXML, std::strlen(kWordsXML), "words", handler));
+    BOOST_CHECK(!handler.arena);
+    
+    const std::vector<std::string_view>& words = handler.result();
+    BOOST_REQUIRE_EQUAL(words.size(), 3);
+    BOOST_CHECK_EQUAL(words[1], "beta");
+    for (std::string_view word : words)
+        std::pmr::get_default_resource()->deallocate(const_cast<char*>(word.data()), word.size(), 1);
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+
+using namespace lxml;
+
+static const char* kItemXML =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<items xmlns=\"urn:items\" xmlns:x=\"urn:extra\">\n"
+    "  <item id=\" 42 \" price=\"3.5\" visible=\"true\" x:tag=\"first\"/>\n"
+    "</items>\n";
+
+/**
+ A handler that inspects the attributes of `item` elements through views.
+ */
+class ItemHandler : public SAXHandler {
+public:
+    int id;
+    double price;
+    bool visible;
+    bool missing;
+    std::string tag;
+    std::string defaultNamespace;
+    
+public:
+    ItemHandler() : id(), price(), visible(), missing(true) {}
+    
+    void startDocument() {}
+    void endDocument() {}
+    
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        if (std::strcmp(qname.localName(), "items") == 0) {
+            defaultNamespace = namespaces.find(0);
+            return;
+        }
+        
+        id = attributes.getInt("id");
+        price = attributes.getDouble("price");
+        visible = attributes.getBool("visible");
+        missing = attributes.getBool("missing", true);
+        tag = std::string(attributes.get(QName("tag", "x", "urn:extra")));
+    }
+    void endElement(const QName& qname) {}
+    
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+/**
+ A handler that receives attributes as maps.
+ */
+class ItemMapHandler : public MapSAXHandler {
+public:
+    std::size_t attributeCount;
+    std::string price;
+    
+public:
+    ItemMapHandler() : attributeCount() {}
+    
+public:
+    void startDocument() {}
+    void endDocument() {}
+    
+    void startElement(const QName& qname, const NamespaceMap& namespaces, const AttributeMap& attributes) {
+        if (std::strcmp(qname.localName(), "item") != 0)
+            return;
+        
+        attributeCount = attributes.size();
+        auto it = attributes.find("price");
+        if (it != attributes.end())
+            price = it->second;
+    }
+    void endElement(const QName& qname) {}
+    
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+
+BOOST_AUTO_TEST_CASE(attributeViewTest) {
+    ItemHandler handler;
+    bool result = parse(kItemXML, std::strlen(kItemXML), "items", handler);
+    
+    BOOST_CHECK(result);
+    BOOST_CHECK_EQUAL(handler.defaultNamespace, "urn:items");
+    BOOST_CHECK_EQUAL(handler.id, 42);
+    BOOST_CHECK_EQUAL(handler.price, 3.5);
+    BOOST_CHECK(handler.visible);
+    BOOST_CHECK(handler.missing);
+    BOOST_CHECK_EQUAL(handler.tag, "first");
+}
+
+BOOST_AUTO_TEST_CASE(attributeMapTest) {
+    ItemMapHandler handler;
+    bool result = parse(kItemXML, std::strlen(kItemXML), "items", handler);
+    
+    BOOST_CHECK(result);
+    BOOST_CHECK_EQUAL(handler.attributeCount, 4);
+    BOOST_CHECK_EQUAL(handler.price, "3.5");
+}
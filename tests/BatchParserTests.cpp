@@ -0,0 +1,133 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/BatchParser.h>
+#include <lxml/ThreadPool.h>
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace lxml;
+
+/**
+ A handler that counts elements, reused across documents.
+ */
+class ElementCountHandler : public SAXHandler {
+public:
+    int count;
+    
+public:
+    ElementCountHandler() : count() {}
+    
+    void startDocument() {
+        count = 0;
+    }
+    void endDocument() {}
+    
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        count += 1;
+    }
+    void endElement(const QName& qname) {}
+    
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+
+BOOST_AUTO_TEST_CASE(threadPoolTest) {
+    std::atomic<int> sum(0);
+    {
+        ThreadPool pool(3);
+        BOOST_CHECK_EQUAL(pool.size(), 3);
+        for (int i = 1; i <= 100; i += 1)
+            pool.submit([&sum, i]() { sum += i; });
+        pool.wait();
+        BOOST_CHECK_EQUAL(sum, 5050);
+        
+        pool.submit([&sum]() { sum = ThreadPool::currentIndex() < 3 ? -1 : 0; });
+    }
+    BOOST_CHECK_EQUAL(sum, -1);
+    BOOST_CHECK_EQUAL(ThreadPool::currentIndex(), ThreadPool::npos);
+}
+
+BOOST_AUTO_TEST_CASE(parseManyTest) {
+    std::vector<std::string> buffers;
+    for (int i = 0; i < 50; i += 1) {
+        std::string xml = "<list>";
+        for (int j = 0; j < i; j += 1)
+            xml += "<item/>";
+        buffers.push_back(xml + "</list>");
+    }
+    buffers[7] = "<list><broken></list>";
+    
+    std::vector<Document> documents;
+    for (const std::string& buffer : buffers)
+        documents.push_back(Document::memory(buffer.data(), buffer.size(), "list"));
+    documents.push_back(Document::file("missing.xml"));
+    
+    BatchOptions options;
+    options.threads = 4;
+    std::vector<int> counts(documents.size(), -1);
+    std::vector<DocumentResult> results = parseMany<ElementCountHandler>(documents,
+        []() { return std::unique_ptr<ElementCountHandler>(new ElementCountHandler); },
+        [&](std::size_t index, ElementCountHandler& handler, bool success) { counts[index] = handler.count; },
+        options);
+    
+    BOOST_REQUIRE_EQUAL(results.size(), documents.size());
+    for (std::size_t i = 0; i < buffers.size(); i += 1) {
+        BOOST_CHECK_EQUAL(results[i].size, buffers[i].size());
+        if (i == 7)
+            continue;
+        BOOST_CHECK(results[i].success);
+        BOOST_CHECK_EQUAL(counts[i], i + 1);
+    }
+    BOOST_CHECK(!results[7].success);
+    BOOST_CHECK(!results.back().success);
+}
+
+BOOST_AUTO_TEST_CASE(parseManyThrowTest) {
+    std::vector<std::string> buffers(20, "<list><item/></list>");
+    std::vector<Document> documents;
+    for (const std::string& buffer : buffers)
+        documents.push_back(Document::memory(buffer.data(), buffer.size(), "list"));
+    
+    // An exception from a callback reaches the caller instead of ending the process
+    BatchOptions options;
+    options.threads = 4;
+    std::atomic<int> parsed(0);
+    BOOST_CHECK_THROW(parseMany<ElementCountHandler>(documents,
+        []() { return std::unique_ptr<ElementCountHandler>(new ElementCountHandler); },
+        [&](std::size_t index, ElementCountHandler& handler, bool success) {
+            if (index == 5)
+                throw std::runtime_error("document");
+            parsed += 1;
+        },
+        options), std::runtime_error);
+    BOOST_CHECK_LT(parsed, 20);
+    
+    BOOST_CHECK_THROW(parseMany<ElementCountHandler>(documents,
+        []() -> std::unique_ptr<ElementCountHandler> { throw std::runtime_error("handler"); },
+        nullptr, options), std::runtime_error);
+}
@@ -0,0 +1,162 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/Decompressor.h>
+#include <lxml/ListHandler.h>
+#include <lxml/StringHandler.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef LXML_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef LXML_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace lxml;
+
+static const int kItemCount = 20000;
+
+static std::string itemsXML() {
+    std::string xml = "<list>";
+    for (int i = 0; i < kItemCount; i += 1)
+        xml += "<item>" + std::to_string(i) + "</item>";
+    return xml + "</list>";
+}
+
+static bool parseItems(const std::string& data, bool stream) {
+    ParseOptions options;
+    options.readAheadBufferSize = 4096;
+    Parser parser(options);
+    
+    StringHandler itemHandler;
+    ListHandler<std::string> handler(itemHandler);
+    bool result;
+    if (stream) {
+        std::istringstream is(data);
+        result = parser.parse(is, "list", handler);
+    } else {
+        result = parser.parse(data.data(), data.size(), "list", handler);
+    }
+    return result && handler.result().size() == kItemCount && handler.result().back() == std::to_string(kItemCount - 1);
+}
+
+/**
+ A handler that keeps the messages of errors.
+ */
+class ErrorHandler : public SAXHandler {
+public:
+    std::vector<std::string> errors;
+    
+public:
+    void startDocument() {}
+    void endDocument() {}
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {}
+    void endElement(const QName& qname) {}
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {
+        errors.push_back(error.message ? error.message : "");
+    }
+};
+
+#ifdef LXML_HAVE_ZLIB
+static std::string gzip(const std::string& data) {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    
+    std::string output(deflateBound(&stream, data.size()) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+#endif
+
+
+BOOST_AUTO_TEST_CASE(detectCompressionTest) {
+    const char* xml = "<list/>";
+    BOOST_CHECK(detectCompression(xml, std::strlen(xml)) == Compression::None);
+    BOOST_CHECK(detectCompression("\x1f\x8b\x08", 3) == Compression::Gzip);
+    BOOST_CHECK(detectCompression("\x28\xb5\x2f\xfd", 4) == Compression::Zstd);
+    BOOST_CHECK(parseItems(itemsXML(), true));
+    
+    // The whole magic number must match, also in streams
+    BOOST_CHECK(detectCompression("\x28\xb5\x2f\xfe", 4) == Compression::None);
+    std::istringstream gzipStream("\x1f\x8b\x08");
+    BOOST_CHECK(detectCompression(gzipStream) == Compression::Gzip);
+    BOOST_CHECK_EQUAL(gzipStream.tellg(), 0);
+    std::istringstream notGzipStream("\x1f\x8c\x08");
+    BOOST_CHECK(detectCompression(notGzipStream) == Compression::None);
+    std::istringstream notZstdStream("\x28\xb5\x2f\xfe<list/>");
+    BOOST_CHECK(detectCompression(notZstdStream) == Compression::None);
+    BOOST_CHECK_EQUAL(notZstdStream.tellg(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(unsupportedCompressionTest) {
+    // Corrupt or unsupported input is reported to the handler
+    std::string data = "\x28\xb5\x2f\xfd" + std::string(64, 'x');
+    Parser parser;
+    ErrorHandler handler;
+    std::istringstream is(data);
+    BOOST_CHECK(!parser.parse(is, "list", handler));
+    BOOST_CHECK_EQUAL(handler.errors.size(), 1);
+    if (isCompressionSupported(Compression::Zstd))
+        BOOST_CHECK(parser.status() == ParseStatus::Error);
+    else
+        BOOST_CHECK(parser.status() == ParseStatus::Unsupported);
+}
+
+#ifdef LXML_HAVE_ZLIB
+BOOST_AUTO_TEST_CASE(gzipTest) {
+    std::string xml = itemsXML();
+    std::string compressed = gzip(xml);
+    BOOST_CHECK(parseItems(compressed, false));
+    BOOST_CHECK(parseItems(compressed, true));
+    
+    // Concatenated members form one document
+    std::size_t half = xml.size() / 2;
+    BOOST_CHECK(parseItems(gzip(xml.substr(0, half)) + gzip(xml.substr(half)), false));
+    
+    BOOST_CHECK(!parseItems(compressed.substr(0, compressed.size() / 2), false));
+}
+#endif
+
+#ifdef LXML_HAVE_ZSTD
+BOOST_AUTO_TEST_CASE(zstdTest) {
+    std::string xml = itemsXML();
+    std::string compressed(ZSTD_compressBound(xml.size()), '\0');
+    compressed.resize(ZSTD_compress(&compressed[0], compressed.size(), xml.data(), xml.size(), 3));
+    BOOST_CHECK(parseItems(compressed, false));
+    BOOST_CHECK(parseItems(compressed, true));
+    BOOST_CHECK(!parseItems(compressed.substr(0, compressed.size() - 8), true));
+}
+#endif
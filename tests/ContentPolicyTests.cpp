@@ -0,0 +1,110 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/BaseRecursiveHandler.h>
+#include <lxml/StringHandler.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+
+using namespace lxml;
+
+static const char* kRecordXML =
+    "<record>\n"
+    "  <raw>  a <b>ignored</b> c  </raw>\n"
+    "  <trimmed>\n    text\n  </trimmed>\n"
+    "  <stream> 1 2 3 </stream>\n"
+    "</record>\n";
+
+/**
+ A handler that keeps its contents exactly as accumulated.
+ */
+class RawHandler : public BaseRecursiveHandler<std::string> {
+public:
+    void endElement(const QName& qname, std::string_view contents) {
+        _result.assign(contents.data(), contents.size());
+    }
+};
+
+/**
+ A handler that receives its contents as they are parsed.
+ */
+class StreamHandler : public BaseRecursiveHandler<std::string> {
+public:
+    bool emptyContents;
+    
+public:
+    StreamHandler() : emptyContents() {}
+    
+    ContentPolicy contentPolicy() const {
+        return ContentPolicy::Stream;
+    }
+    void characters(const char* chars, std::size_t length) {
+        _result.append(chars, length);
+    }
+    void endElement(const QName& qname, std::string_view contents) {
+        emptyContents = contents.empty();
+    }
+};
+
+/**
+ A record handler that ignores its own contents and routes sub-elements.
+ */
+class RecordHandler : public BaseRecursiveHandler<bool> {
+public:
+    RawHandler raw;
+    StringHandler trimmed;
+    StreamHandler stream;
+    bool emptyContents;
+    
+public:
+    RecordHandler() : emptyContents() {}
+    
+    ContentPolicy contentPolicy() const {
+        return ContentPolicy::Ignore;
+    }
+    RecursiveHandler* startSubElement(const QName& qname) {
+        if (std::strcmp(qname.localName(), "raw") == 0)
+            return &raw;
+        if (std::strcmp(qname.localName(), "trimmed") == 0)
+            return &trimmed;
+        if (std::strcmp(qname.localName(), "stream") == 0)
+            return &stream;
+        return 0;
+    }
+    void endElement(const QName& qname, std::string_view contents) {
+        emptyContents = contents.empty();
+    }
+};
+
+
+BOOST_AUTO_TEST_CASE(contentPolicyTest) {
+    RecordHandler handler;
+    bool result = parse(kRecordXML, std::strlen(kRecordXML), "record", handler);
+    
+    BOOST_CHECK(result);
+    BOOST_CHECK(handler.emptyContents);
+    BOOST_CHECK_EQUAL(handler.raw.result(), "  a  c  ");
+    BOOST_CHECK_EQUAL(handler.trimmed.result(), "text");
+    BOOST_CHECK_EQUAL(handler.stream.result(), " 1 2 3 ");
+    BOOST_CHECK(handler.stream.emptyContents);
+}
@@ -0,0 +1,294 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/EventTape.h>
+#include <lxml/ListHandler.h>
+#include <lxml/StringHandler.h>
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace lxml;
+
+static const char* kTapeXML =
+    "<feed xmlns='urn:feed' xmlns:x='urn:extra'>"
+        "<item id='1' x:flag='yes'>first &amp; best</item>"
+        "<skip><item id='hidden'>deep</item></skip>"
+        "<item id='2'><x:note>note</x:note>second</item>"
+    "</feed>";
+
+/**
+ Logs events as text, skipping `skip` elements when asked to.
+ */
+class LogHandler : public SAXHandler {
+public:
+    std::string log;
+    bool skip = false;
+    int stopAfter = -1;
+    int elements = 0;
+    
+public:
+    void startDocument() {
+        log += "[";
+    }
+    void endDocument() {
+        log += "]";
+    }
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        log += "<";
+        log += name(qname);
+        for (Namespace ns : namespaces)
+            log += std::string(" ns:") + (ns.prefix ? ns.prefix : "") + "=" + ns.namespaceURI;
+        for (Attribute attribute : attributes)
+            log += " " + name(attribute.qname()) + "=" + std::string(attribute.value());
+        log += ">";
+        if (skip && std::strcmp(qname.localName(), "skip") == 0)
+            ParseContext::current()->skipSubtree();
+        if (++elements == stopAfter)
+            ParseContext::current()->stop();
+    }
+    void endElement(const QName& qname) {
+        log += "</" + name(qname) + ">";
+    }
+    void characters(const char* chars, std::size_t length) {
+        log.append(chars, length);
+    }
+    void error(const xmlError& error) {}
+    
+private:
+    static std::string name(const QName& qname) {
+        std::string name;
+        if (qname.namespaceURI())
+            name += std::string("{") + qname.namespaceURI() + "}";
+        if (qname.prefix())
+            name += std::string(qname.prefix()) + ":";
+        return name + qname.localName();
+    }
+};
+
+static std::string readFile(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const char* path, const std::string& contents) {
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+}
+
+BOOST_AUTO_TEST_CASE(tapeReplayTest) {
+    static const char* path = "lxml_tape_replay_test.tape";
+    BOOST_REQUIRE(EventTape::record(kTapeXML, std::strlen(kTapeXML), path));
+    
+    LogHandler parsed;
+    BOOST_CHECK(parse(kTapeXML, std::strlen(kTapeXML), "tape.xml", parsed));
+    
+    EventTape tape;
+    BOOST_REQUIRE(tape.open(path, EventTape::hash(kTapeXML, std::strlen(kTapeXML))));
+    BOOST_CHECK_EQUAL(tape.sourceSize(), std::strlen(kTapeXML));
+    
+    // Replays can be repeated
+    for (int i = 0; i < 2; ++i) {
+        LogHandler replayed;
+        BOOST_CHECK(tape.replay(replayed));
+        BOOST_CHECK(tape.status() == ParseStatus::Ok);
+        BOOST_CHECK_EQUAL(replayed.log, parsed.log);
+    }
+    
+    // Recursive handlers see the same contents
+    static const char* kListXML = "<list><item>a</item><item>b &lt; c</item><item/></list>";
+    BOOST_REQUIRE(EventTape::record(kListXML, std::strlen(kListXML), path));
+    BOOST_REQUIRE(tape.open(path));
+    StringHandler itemHandler;
+    ListHandler<std::string> listHandler(itemHandler);
+    BOOST_CHECK(tape.replay(listHandler));
+    BOOST_REQUIRE_EQUAL(listHandler.result().size(), 3u);
+    BOOST_CHECK_EQUAL(listHandler.result()[1], "b < c");
+    BOOST_CHECK_EQUAL(listHandler.result()[2], "");
+    
+    tape.close();
+    std::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(tapeSkipTest) {
+    static const char* path = "lxml_tape_skip_test.tape";
+    BOOST_REQUIRE(EventTape::record(kTapeXML, std::strlen(kTapeXML), path));
+    
+    LogHandler parsed;
+    parsed.skip = true;
+    BOOST_CHECK(parse(kTapeXML, std::strlen(kTapeXML), "tape.xml", parsed));
+    BOOST_CHECK(parsed.log.find("hidden") == std::string::npos);
+    
+    EventTape tape;
+    BOOST_REQUIRE(tape.open(path));
+    LogHandler replayed;
+    replayed.skip = true;
+    BOOST_CHECK(tape.replay(replayed));
+    BOOST_CHECK_EQUAL(replayed.log, parsed.log);
+    tape.close();
+    
+    // Without the document element's length, skipping it decodes the events
+    std::string contents = readFile(path);
+    std::memset(&contents[sizeof(TapeHeader) + 1], 0, sizeof(std::uint32_t));
+    writeFile(path, contents);
+    
+    class SkipRoot : public LogHandler {
+    public:
+        void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+            LogHandler::startElement(qname, namespaces, attributes);
+            ParseContext::current()->skipSubtree();
+        }
+    } skipRoot;
+    BOOST_REQUIRE(tape.open(path));
+    BOOST_CHECK(tape.replay(skipRoot));
+    BOOST_CHECK_EQUAL(skipRoot.log, "[<{urn:feed}feed ns:=urn:feed ns:x=urn:extra></{urn:feed}feed>]");
+    
+    tape.close();
+    std::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(tapeLateSkipTest) {
+    static const char* path = "lxml_tape_late_skip_test.tape";
+    BOOST_REQUIRE(EventTape::record(kTapeXML, std::strlen(kTapeXML), path));
+    
+    // Skipping outside startElement has no effect, and doesn't carry over to
+    // the next element
+    class LateSkip : public LogHandler {
+    public:
+        void endElement(const QName& qname) {
+            LogHandler::endElement(qname);
+            ParseContext::current()->skipSubtree();
+        }
+        void characters(const char* chars, std::size_t length) {
+            LogHandler::characters(chars, length);
+            ParseContext::current()->skipSubtree();
+        }
+    };
+    
+    LateSkip parsed;
+    BOOST_CHECK(parse(kTapeXML, std::strlen(kTapeXML), "tape.xml", parsed));
+    BOOST_CHECK(parsed.log.find("hidden") != std::string::npos);
+    
+    EventTape tape;
+    BOOST_REQUIRE(tape.open(path));
+    LateSkip replayed;
+    BOOST_CHECK(tape.replay(replayed));
+    BOOST_CHECK_EQUAL(replayed.log, parsed.log);
+    
+    tape.close();
+    std::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(tapeStopTest) {
+    static const char* path = "lxml_tape_stop_test.tape";
+    BOOST_REQUIRE(EventTape::record(kTapeXML, std::strlen(kTapeXML), path));
+    
+    EventTape tape;
+    BOOST_REQUIRE(tape.open(path));
+    LogHandler handler;
+    handler.stopAfter = 2;
+    BOOST_CHECK(!tape.replay(handler));
+    BOOST_CHECK(tape.status() == ParseStatus::Stopped);
+    BOOST_CHECK_EQUAL(handler.elements, 2);
+    
+    LogHandler complete;
+    BOOST_CHECK(tape.replay(complete));
+    BOOST_CHECK(tape.status() == ParseStatus::Ok);
+    
+    tape.close();
+    std::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(tapeCacheTest) {
+    static const char* xmlPath = "lxml_tape_cache_test.xml";
+    static const char* path = "lxml_tape_cache_test.tape";
+    std::remove(path);
+    writeFile(xmlPath, kTapeXML);
+    
+    EventTape tape;
+    BOOST_REQUIRE(tape.openCached(xmlPath, path));
+    std::uint64_t firstHash = tape.sourceHash();
+    LogHandler first;
+    BOOST_CHECK(tape.replay(first));
+    BOOST_CHECK(first.log.find("first &") != std::string::npos);
+    
+    // A changed file makes the tape stale
+    static const char* kChangedXML = "<feed><item id='3'>changed</item></feed>";
+    writeFile(xmlPath, kChangedXML);
+    BOOST_CHECK(!tape.open(path, EventTape::hash(kChangedXML, std::strlen(kChangedXML))));
+    BOOST_REQUIRE(tape.openCached(xmlPath, path));
+    BOOST_CHECK_NE(tape.sourceHash(), firstHash);
+    LogHandler changed;
+    BOOST_CHECK(tape.replay(changed));
+    BOOST_CHECK_EQUAL(changed.log, "[<feed><item id=3>changed</item></feed>]");
+    
+    // Invalid XML leaves no tape behind
+    tape.close();
+    std::remove(path);
+    writeFile(xmlPath, "<feed><item></feed>");
+    BOOST_CHECK(!tape.openCached(xmlPath, path));
+    BOOST_CHECK(!tape.open(path));
+    
+    std::remove(xmlPath);
+}
+
+BOOST_AUTO_TEST_CASE(tapeCorruptTest) {
+    static const char* path = "lxml_tape_corrupt_test.tape";
+    BOOST_REQUIRE(EventTape::record(kTapeXML, std::strlen(kTapeXML), path));
+    std::string contents = readFile(path);
+    EventTape tape;
+    
+    writeFile(path, contents.substr(0, contents.size() - 1));
+    BOOST_CHECK(!tape.open(path));
+    writeFile(path, "not a tape");
+    BOOST_CHECK(!tape.open(path));
+    BOOST_CHECK(!tape.open("lxml_missing.tape"));
+    
+    // An unknown event
+    std::string corrupt = contents;
+    corrupt[sizeof(TapeHeader)] = 9;
+    writeFile(path, corrupt);
+    BOOST_REQUIRE(tape.open(path));
+    LogHandler handler;
+    BOOST_CHECK(!tape.replay(handler));
+    BOOST_CHECK(tape.status() == ParseStatus::Error);
+    
+    // Not open
+    tape.close();
+    BOOST_CHECK(!tape.replay(handler));
+    
+    std::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(tapeHashTest) {
+    // xxHash64 reference values
+    BOOST_CHECK_EQUAL(EventTape::hash("", 0), 0xEF46DB3751D8E999ull);
+    BOOST_CHECK_EQUAL(EventTape::hash("abc", 3), 0x44BC2CF5AD770999ull);
+    
+    std::string long1(100, 'a');
+    std::string long2 = long1;
+    long2[50] = 'b';
+    BOOST_CHECK_NE(EventTape::hash(long1.data(), long1.size()), EventTape::hash(long2.data(), long2.size()));
+}
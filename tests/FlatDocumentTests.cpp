@@ -0,0 +1,146 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/FlatDocument.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace lxml;
+
+static const char* kLibraryXML =
+    "<library xmlns:x='urn:extra'>\n"
+    "  <book id='1' lang='en'>\n"
+    "    <title>Dune</title>\n"
+    "    <author>Frank Herbert</author>\n"
+    "  </book>\n"
+    "  <book id='2'>\n"
+    "    <title>Solaris</title>\n"
+    "    <x:note>mixed <b>bold</b> text</x:note>\n"
+    "  </book>\n"
+    "  <shelf/>\n"
+    "</library>";
+
+static FlatDocument build(const char* xml, bool keepWhitespace = false) {
+    FlatDocumentBuilder builder(keepWhitespace);
+    BOOST_CHECK(parse(xml, std::strlen(xml), "library.xml", builder));
+    return std::move(builder.document());
+}
+
+BOOST_AUTO_TEST_CASE(flatDocumentTreeTest) {
+    FlatDocument document = build(kLibraryXML);
+    BOOST_REQUIRE_EQUAL(document.size(), 9u);
+    
+    // Preorder
+    std::vector<std::string> names;
+    for (FlatDocument::NodeId node = 0; node < document.size(); ++node)
+        names.emplace_back(document.localName(node));
+    const std::vector<std::string> expected = {"library", "book", "title", "author", "book", "title", "note", "b", "shelf"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(names.begin(), names.end(), expected.begin(), expected.end());
+    
+    FlatDocument::NodeId library = document.root();
+    BOOST_CHECK_EQUAL(library, 0u);
+    BOOST_CHECK_EQUAL(document.parent(library), FlatDocument::npos);
+    BOOST_CHECK_EQUAL(document.subtreeEnd(library), document.size());
+    
+    FlatDocument::NodeId first = document.firstChild(library);
+    FlatDocument::NodeId second = document.nextSibling(first);
+    BOOST_CHECK_EQUAL(first, 1u);
+    BOOST_CHECK_EQUAL(second, 4u);
+    BOOST_CHECK_EQUAL(document.subtreeEnd(first), second);
+    BOOST_CHECK_EQUAL(document.parent(second), library);
+    
+    FlatDocument::NodeId shelf = document.nextSibling(second);
+    BOOST_CHECK_EQUAL(document.localName(shelf), "shelf");
+    BOOST_CHECK_EQUAL(document.nextSibling(shelf), FlatDocument::npos);
+    BOOST_CHECK_EQUAL(document.firstChild(shelf), FlatDocument::npos);
+}
+
+BOOST_AUTO_TEST_CASE(flatDocumentLookupTest) {
+    FlatDocument document = build(kLibraryXML);
+    FlatDocument::NodeId library = document.root();
+    
+    FlatDocument::NameId book = document.findName("book");
+    BOOST_REQUIRE_NE(book, FlatDocument::npos);
+    std::vector<std::string> ids;
+    for (FlatDocument::NodeId node = document.child(library, book); node != FlatDocument::npos; node = document.nextSibling(node, book))
+        ids.emplace_back(document.attribute(node, "id"));
+    BOOST_CHECK_EQUAL(ids.size(), 2u);
+    BOOST_CHECK_EQUAL(ids[0], "1");
+    BOOST_CHECK_EQUAL(ids[1], "2");
+    
+    FlatDocument::NodeId dune = document.child(library, "book");
+    BOOST_CHECK_EQUAL(document.attribute(dune, "lang"), "en");
+    BOOST_CHECK_EQUAL(document.attribute(dune, "missing", "none"), "none");
+    BOOST_CHECK_EQUAL(document.attributeCount(dune), 2u);
+    BOOST_CHECK_EQUAL(document.nameLocalName(document.attributeName(dune, 1)), "lang");
+    BOOST_CHECK_EQUAL(document.attributeValue(dune, 1), "en");
+    BOOST_CHECK_EQUAL(document.text(document.child(dune, "author")), "Frank Herbert");
+    
+    // Names are qualified by namespace
+    FlatDocument::NodeId solaris = document.nextSibling(dune, book);
+    BOOST_CHECK_EQUAL(document.child(solaris, "note"), FlatDocument::npos);
+    FlatDocument::NodeId note = document.child(solaris, "note", "urn:extra");
+    BOOST_REQUIRE_NE(note, FlatDocument::npos);
+    BOOST_CHECK_EQUAL(document.nameNamespaceURI(document.name(note)), "urn:extra");
+    BOOST_CHECK_EQUAL(document.findName("unknown"), FlatDocument::npos);
+    BOOST_CHECK_EQUAL(document.child(library, "unknown"), FlatDocument::npos);
+    BOOST_CHECK_EQUAL(document.attributeCount(document.child(library, "shelf")), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(flatDocumentTextTest) {
+    FlatDocument document = build(kLibraryXML);
+    FlatDocument::NodeId library = document.root();
+    FlatDocument::NodeId solaris = document.nextSibling(document.firstChild(library));
+    
+    // Indentation is dropped, mixed content keeps the element's own text
+    BOOST_CHECK_EQUAL(document.text(library), "");
+    BOOST_CHECK_EQUAL(document.text(solaris), "");
+    FlatDocument::NodeId note = document.nextSibling(document.firstChild(solaris));
+    BOOST_CHECK_EQUAL(document.text(note), "mixed  text");
+    BOOST_CHECK_EQUAL(document.text(document.firstChild(note)), "bold");
+    
+    FlatDocument kept = build(kLibraryXML, true);
+    BOOST_CHECK_EQUAL(kept.text(kept.root()), "\n  \n  \n  \n");
+}
+
+BOOST_AUTO_TEST_CASE(flatDocumentReuseTest) {
+    FlatDocumentBuilder builder;
+    Parser parser;
+    BOOST_CHECK(parser.parse(kLibraryXML, std::strlen(kLibraryXML), "library.xml", builder));
+    BOOST_CHECK_EQUAL(builder.document().size(), 9u);
+    
+    static const char* kSmallXML = "<a x='1'><b>text</b></a>";
+    BOOST_CHECK(parser.parse(kSmallXML, std::strlen(kSmallXML), "small.xml", builder));
+    const FlatDocument& document = builder.document();
+    BOOST_CHECK_EQUAL(document.size(), 2u);
+    BOOST_CHECK_EQUAL(document.nameCount(), 3u);
+    BOOST_CHECK_EQUAL(document.attribute(0, "x"), "1");
+    BOOST_CHECK_EQUAL(document.text(1), "text");
+    BOOST_CHECK_EQUAL(document.findName("book"), FlatDocument::npos);
+    BOOST_CHECK_GT(document.memoryUsage(), 0u);
+    
+    FlatDocument empty;
+    BOOST_CHECK(empty.empty());
+    BOOST_CHECK_EQUAL(empty.root(), FlatDocument::npos);
+}
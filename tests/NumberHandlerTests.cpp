@@ -0,0 +1,97 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/IntegerHandler.h>
+#include <lxml/NumberHandler.h>
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstring>
+
+using namespace lxml;
+
+
+BOOST_AUTO_TEST_CASE(parseNumberTest) {
+    std::int32_t i32 = 0;
+    BOOST_CHECK(parseNumber(" \n+42\t", i32) == NumberStatus::Ok);
+    BOOST_CHECK_EQUAL(i32, 42);
+    BOOST_CHECK(parseNumber("-7", i32) == NumberStatus::Ok);
+    BOOST_CHECK_EQUAL(i32, -7);
+    BOOST_CHECK(parseNumber("2147483648", i32) == NumberStatus::Overflow);
+    BOOST_CHECK(parseNumber("12abc", i32) == NumberStatus::Invalid);
+    BOOST_CHECK(parseNumber("+-1", i32) == NumberStatus::Invalid);
+    BOOST_CHECK(parseNumber("   ", i32) == NumberStatus::Empty);
+    BOOST_CHECK_EQUAL(i32, -7);
+    
+    std::uint64_t u64 = 0;
+    BOOST_CHECK(parseNumber("18446744073709551615", u64) == NumberStatus::Ok);
+    BOOST_CHECK_EQUAL(u64, UINT64_MAX);
+    BOOST_CHECK(parseNumber("-1", u64) == NumberStatus::Invalid);
+    
+    double d = 0;
+    BOOST_CHECK(parseNumber(" 1.5e3 ", d) == NumberStatus::Ok);
+    BOOST_CHECK_EQUAL(d, 1500.0);
+    BOOST_CHECK(parseNumber("1,5", d) == NumberStatus::Invalid);
+}
+
+/**
+ A handler that parses the children of its element with number handlers.
+ */
+class SampleHandler : public BaseRecursiveHandler<bool> {
+public:
+    IntegerHandler count;
+    Int64Handler big;
+    FloatHandler ratio;
+    NumberStatus badStatus;
+    
+public:
+    SampleHandler() : badStatus(NumberStatus::Ok) {}
+    
+    RecursiveHandler* startSubElement(const QName& qname) {
+        if (std::strcmp(qname.localName(), "count") == 0 || std::strcmp(qname.localName(), "bad") == 0)
+            return &count;
+        if (std::strcmp(qname.localName(), "big") == 0)
+            return &big;
+        if (std::strcmp(qname.localName(), "ratio") == 0)
+            return &ratio;
+        return 0;
+    }
+    
+    void endSubElement(const QName& qname, RecursiveHandler* handler) {
+        if (std::strcmp(qname.localName(), "bad") == 0)
+            badStatus = count.status();
+    }
+};
+
+BOOST_AUTO_TEST_CASE(numberHandlerTest) {
+    const char* xml =
+        "<sample><bad>x1</bad><count> 12 </count><big>9000000000</big><ratio>0.25</ratio></sample>";
+    SampleHandler handler;
+    bool result = parse(xml, std::strlen(xml), "sample", handler);
+    
+    BOOST_CHECK(result);
+    BOOST_CHECK(handler.badStatus == NumberStatus::Invalid);
+    BOOST_CHECK(handler.count.status() == NumberStatus::Ok);
+    BOOST_CHECK_EQUAL(handler.count.result(), 12);
+    BOOST_CHECK_EQUAL(handler.big.result(), 9000000000ll);
+    BOOST_CHECK_EQUAL(handler.ratio.result(), 0.25f);
+    BOOST_CHECK_EQUAL(IntegerHandler::parseInteger("garbage"), 0);
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/NumericArrayHandler.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace lxml;
+
+static const int kSampleCount = 100000;
+
+static std::string samplesXML() {
+    std::string xml = "<samples>";
+    for (int i = 0; i < kSampleCount; i += 1) {
+        xml += std::to_string(i);
+        xml += i % 7 == 0 ? ".25\n\t" : ".5 ";
+    }
+    xml += "</samples>";
+    return xml;
+}
+
+
+BOOST_AUTO_TEST_CASE(numericArrayTest) {
+    // Parsing from a stream delivers the contents in many chunks
+    std::istringstream stream(samplesXML());
+    NumericArrayHandler<double> handler;
+    bool result = parse(stream, "samples", handler);
+    
+    BOOST_CHECK(result);
+    BOOST_CHECK(handler.status() == NumberStatus::Ok);
+    BOOST_REQUIRE_EQUAL(handler.result().size(), kSampleCount);
+    
+    int mismatches = 0;
+    for (int i = 0; i < kSampleCount; i += 1) {
+        if (handler.result()[i] != i + (i % 7 == 0 ? 0.25 : 0.5))
+            mismatches += 1;
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+BOOST_AUTO_TEST_CASE(numericArrayBufferTest) {
+    const char* xml = "<values> 1 2 <skip>9</skip>3 x 5 6 </values>";
+    int buffer[4] = {};
+    NumericArrayHandler<int> handler;
+    handler.setBuffer(buffer, 4);
+    bool result = parse(xml, std::strlen(xml), "values", handler);
+    
+    BOOST_CHECK(result);
+    BOOST_CHECK(handler.result().empty());
+    BOOST_CHECK(handler.status() == NumberStatus::Invalid);
+    BOOST_CHECK(handler.truncated());
+    BOOST_CHECK_EQUAL(handler.size(), 4);
+    BOOST_CHECK_EQUAL(buffer[2], 3);
+    BOOST_CHECK_EQUAL(buffer[3], 0);
+}
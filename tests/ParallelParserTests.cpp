@@ -0,0 +1,174 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/ParallelParser.h>
+#include <lxml/RecordScanner.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace lxml;
+
+static const int kRecordCount = 20000;
+
+static std::string recordsXML() {
+    std::string xml =
+        "<?xml version=\"1.0\"?>\n"
+        "<!DOCTYPE feed [ <!ENTITY co \"a > b\"> <!-- ]> --> ]>\n"
+        "<feed><!-- <record id=\"-1\"/> --><records source=\"a > b\">\n";
+    for (int i = 0; i < kRecordCount; i += 1) {
+        xml += "  <record id=\"" + std::to_string(i) + "\" note='x/> y'>";
+        xml += "<name>A &amp; B</name><![CDATA[</record></feed>]]><?pi </record>?></record>\n";
+    }
+    xml += "</records></feed>\n";
+    return xml;
+}
+
+/**
+ A record handler that reads the id attribute.
+ */
+class IdHandler : public BaseRecursiveHandler<int> {
+public:
+    void startElement(const QName& qname, const AttributeView& attributes) {
+        _result = attributes.getInt("id", -1);
+    }
+};
+
+static bool parseIds(ParallelParser& parser, const std::string& xml, std::vector<int>& ids) {
+    return parser.parseRecords<int>(xml.data(), xml.size(), "records", "record",
+                                    []() { return std::unique_ptr<BaseRecursiveHandler<int>>(new IdHandler); },
+                                    [&](int&& id) { ids.push_back(id); });
+}
+
+static bool inOrder(const std::vector<int>& ids) {
+    for (std::size_t i = 0; i < ids.size(); i += 1) {
+        if (ids[i] != static_cast<int>(i))
+            return false;
+    }
+    return true;
+}
+
+
+BOOST_AUTO_TEST_CASE(recordScannerTest) {
+    std::string xml = recordsXML();
+    RecordLayout layout;
+    BOOST_REQUIRE(RecordScanner(xml.data(), xml.size()).scan("record", 4096, layout));
+    
+    BOOST_CHECK_EQUAL(xml.compare(layout.preludeLength, 12, "<record id=\""), 0);
+    BOOST_CHECK_EQUAL(layout.suffix, "</records></feed>");
+    BOOST_CHECK(layout.splits.size() > 10);
+    BOOST_CHECK_EQUAL(xml.compare(layout.splits.back(), 10, "</records>"), 0);
+    for (std::size_t i = 1; i + 1 < layout.splits.size(); i += 1)
+        BOOST_CHECK_EQUAL(xml.compare(layout.splits[i], 7, "<record"), 0);
+    
+    const char* nested = "<feed><a><record/></a><b><record/></b></feed>";
+    BOOST_CHECK(!RecordScanner(nested, std::strlen(nested)).scan("record", 1, layout));
+}
+
+BOOST_AUTO_TEST_CASE(parallelParseTest) {
+    ParallelOptions options;
+    options.threads = 4;
+    options.chunkSize = 4096;
+    options.maxPendingChunks = 3;
+    ParallelParser parser(options);
+    
+    std::vector<int> ids;
+    BOOST_CHECK(parseIds(parser, recordsXML(), ids));
+    BOOST_CHECK(parser.chunkCount() > 1);
+    BOOST_CHECK_EQUAL(ids.size(), kRecordCount);
+    BOOST_CHECK(inOrder(ids));
+}
+
+BOOST_AUTO_TEST_CASE(parallelFallbackTest) {
+    ParallelOptions options;
+    options.threads = 4;
+    options.chunkSize = 16;
+    ParallelParser parser(options);
+    
+    std::vector<int> ids;
+    std::string nested = "<feed><a><record id=\"0\"/></a><b><record id=\"1\"/></b></feed>";
+    BOOST_CHECK(parseIds(parser, nested, ids));
+    BOOST_CHECK_EQUAL(parser.chunkCount(), 1);
+    BOOST_CHECK_EQUAL(ids.size(), 2);
+    BOOST_CHECK(inOrder(ids));
+}
+
+BOOST_AUTO_TEST_CASE(parallelErrorTest) {
+    ParallelOptions options;
+    options.threads = 4;
+    options.chunkSize = 4096;
+    ParallelParser parser(options);
+    
+    std::string xml = recordsXML();
+    std::size_t broken = xml.find("<record id=\"10000\"");
+    xml.replace(broken + 1, 6, "recorX");
+    
+    std::vector<int> ids;
+    BOOST_CHECK(!parseIds(parser, xml, ids));
+    BOOST_CHECK_EQUAL(ids.size(), 10000);
+    BOOST_CHECK(inOrder(ids));
+}
+
+BOOST_AUTO_TEST_CASE(parallelPrefixTest) {
+    ParallelOptions options;
+    options.threads = 4;
+    options.chunkSize = 4096;
+    ParallelParser parser(options);
+    
+    // Records are matched by local name both when splitting and parsing
+    std::string xml = recordsXML();
+    std::string::size_type position = 0;
+    while ((position = xml.find("record", position)) != std::string::npos) {
+        if (xml[position - 1] == '<' || xml[position - 1] == '/')
+            xml.insert(position, "r:");
+        position += 6;
+    }
+    xml.replace(xml.find("<feed>"), 6, "<feed xmlns:r=\"urn:records\">");
+    
+    std::vector<int> ids;
+    BOOST_CHECK(parseIds(parser, xml, ids));
+    BOOST_CHECK(parser.chunkCount() > 1);
+    BOOST_CHECK_EQUAL(ids.size(), kRecordCount);
+    BOOST_CHECK(inOrder(ids));
+}
+
+BOOST_AUTO_TEST_CASE(parallelThrowTest) {
+    ParallelOptions options;
+    options.threads = 4;
+    options.chunkSize = 4096;
+    options.maxPendingChunks = 2;
+    ParallelParser parser(options);
+    
+    std::string xml = recordsXML();
+    std::vector<int> ids;
+    BOOST_CHECK_THROW(parser.parseRecords<int>(xml.data(), xml.size(), "records", "record",
+                                               []() { return std::unique_ptr<BaseRecursiveHandler<int>>(new IdHandler); },
+                                               [&](int&& id) {
+                                                   if (id == 1000)
+                                                       throw std::runtime_error("record");
+                                                   ids.push_back(id);
+                                               }),
+                      std::runtime_error);
+    BOOST_CHECK_EQUAL(ids.size(), 1000);
+}
@@ -0,0 +1,135 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/ListHandler.h>
+#include <lxml/StringHandler.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+
+using namespace lxml;
+
+static const char* kStatsXML =
+    "<feed version='1'>"
+        "<record id='1' kind='a'><value>abc</value></record>"
+        "<record id='2' kind='b'><value>de</value></record>"
+    "</feed>";
+
+class NullHandler : public SAXHandler {
+public:
+    void startDocument() {}
+    void endDocument() {}
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {}
+    void endElement(const QName& qname) {}
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+/**
+ Statically dispatched handler that only wants elements.
+ */
+struct ElementCounter {
+    int elements = 0;
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        ++elements;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(statsTest) {
+    ParseOptions options;
+    options.collectStats = true;
+    Parser parser(options);
+    NullHandler handler;
+    BOOST_CHECK(parser.parse(kStatsXML, std::strlen(kStatsXML), "stats.xml", handler));
+    
+    ParseStats stats = parser.stats();
+    BOOST_CHECK_EQUAL(stats.bytes, std::strlen(kStatsXML));
+    BOOST_CHECK_GE(stats.chunks, 1u);
+    BOOST_CHECK_EQUAL(stats.elements, 5u);
+    BOOST_CHECK_EQUAL(stats.attributes, 5u);
+    BOOST_CHECK_EQUAL(stats.textBytes, 5u);
+    BOOST_CHECK_EQUAL(stats.maxDepth, 3u);
+    BOOST_CHECK_GE(stats.parseSeconds, stats.handlerSeconds);
+    BOOST_CHECK_GE(stats.libxmlSeconds(), 0.0);
+    
+    // Statistics are per parse
+    static const char* kSmallXML = "<feed/>";
+    BOOST_CHECK(parser.parse(kSmallXML, std::strlen(kSmallXML), "small.xml", handler));
+    stats = parser.stats();
+    BOOST_CHECK_EQUAL(stats.bytes, std::strlen(kSmallXML));
+    BOOST_CHECK_EQUAL(stats.elements, 1u);
+    BOOST_CHECK_EQUAL(stats.attributes, 0u);
+    BOOST_CHECK_EQUAL(stats.maxDepth, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(staticStatsTest) {
+    ParseOptions options;
+    options.collectStats = true;
+    Parser parser(options);
+    ElementCounter handler;
+    BOOST_CHECK(parser.parse(kStatsXML, std::strlen(kStatsXML), "stats.xml", handler));
+    BOOST_CHECK_EQUAL(handler.elements, 5);
+    
+    ParseStats stats = parser.stats();
+    BOOST_CHECK_EQUAL(stats.elements, 5u);
+    BOOST_CHECK_EQUAL(stats.attributes, 5u);
+    BOOST_CHECK_EQUAL(stats.maxDepth, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(allocationStatsTest) {
+    ParseOptions options;
+    options.collectStats = true;
+    Parser parser(options);
+    
+    std::string xml = "<list>";
+    for (int i = 0; i < 100; ++i)
+        xml += "<item>" + std::string(40, 'a' + i % 26) + "</item>";
+    xml += "</list>";
+    
+    StringHandler itemHandler;
+    ListHandler<std::string> listHandler(itemHandler);
+    BOOST_CHECK(parser.parse(xml.data(), xml.size(), "list.xml", listHandler));
+    BOOST_CHECK_EQUAL(listHandler.result().size(), 100u);
+    BOOST_CHECK_GT(parser.stats().contentAllocations, 0u);
+    
+    // Attribute maps count their nodes and long values
+    class MapHandler : public NullHandler {
+    public:
+        void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+            attributes.toMap();
+        }
+    } mapHandler;
+    static const char* kAttributesXML = "<a x='1' y='a value too long for the small string buffer'/>";
+    BOOST_CHECK(parser.parse(kAttributesXML, std::strlen(kAttributesXML), "attributes.xml", mapHandler));
+    BOOST_CHECK_EQUAL(parser.stats().attributeMapAllocations, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(noStatsTest) {
+    Parser parser;
+    NullHandler handler;
+    BOOST_CHECK(parser.parse(kStatsXML, std::strlen(kStatsXML), "stats.xml", handler));
+    
+    ParseStats stats = parser.stats();
+    BOOST_CHECK_EQUAL(stats.bytes, 0u);
+    BOOST_CHECK_EQUAL(stats.elements, 0u);
+    BOOST_CHECK_EQUAL(stats.parseSeconds, 0.0);
+}
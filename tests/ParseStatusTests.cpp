@@ -0,0 +1,223 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace lxml;
+
+static std::string makeFeed(int records) {
+    std::string xml = "<feed>";
+    for (int i = 0; i < records; ++i)
+        xml += "<record id='" + std::to_string(i) + "'><value>" + std::to_string(i) + "</value></record>";
+    xml += "</feed>";
+    return xml;
+}
+
+/**
+ Counts records and stops or cancels at a given one.
+ */
+class RecordCounter : public SAXHandler {
+public:
+    int records = 0;
+    int stopAt = -1;
+    CancellationToken* token = 0;
+    int sleepAt = -1;
+    
+public:
+    void startDocument() {}
+    void endDocument() {}
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        if (std::strcmp(qname.localName(), "record") != 0)
+            return;
+        if (records == sleepAt)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        if (records++ == stopAt) {
+            if (token)
+                token->cancel();
+            else
+                ParseContext::current()->stop();
+        }
+    }
+    void endElement(const QName& qname) {}
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+BOOST_AUTO_TEST_CASE(stopTest) {
+    std::string xml = makeFeed(100000);
+    Parser parser;
+    RecordCounter handler;
+    handler.stopAt = 2;
+    BOOST_CHECK(!parser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(parser.status() == ParseStatus::Stopped);
+    BOOST_CHECK_EQUAL(handler.records, 3);
+    
+    // Streams aren't read any further
+    std::istringstream stream(xml);
+    handler.records = 0;
+    BOOST_CHECK(!parser.parse(stream, "feed.xml", handler));
+    BOOST_CHECK(parser.status() == ParseStatus::Stopped);
+    BOOST_CHECK_EQUAL(handler.records, 3);
+    BOOST_CHECK_LT(static_cast<std::size_t>(stream.tellg()), xml.size() / 10);
+    
+    // The parser is usable afterwards
+    handler.records = 0;
+    handler.stopAt = -1;
+    BOOST_CHECK(parser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(parser.status() == ParseStatus::Ok);
+    BOOST_CHECK_EQUAL(handler.records, 100000);
+    
+    static const char* kInvalidXML = "<feed><record></feed>";
+    BOOST_CHECK(!parser.parse(kInvalidXML, std::strlen(kInvalidXML), "invalid.xml", handler));
+    BOOST_CHECK(parser.status() == ParseStatus::Error);
+}
+
+BOOST_AUTO_TEST_CASE(cancelTest) {
+    std::string xml = makeFeed(100000);
+    CancellationToken token;
+    ParseOptions options;
+    options.cancel = &token;
+    Parser parser(options);
+    
+    // Cancelled while parsing, takes effect at the next chunk
+    RecordCounter handler;
+    handler.stopAt = 10;
+    handler.token = &token;
+    BOOST_CHECK(!parser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(parser.status() == ParseStatus::Cancelled);
+    BOOST_CHECK_LT(handler.records, 100000);
+    
+    // Already cancelled
+    handler.records = 0;
+    BOOST_CHECK(!parser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(parser.status() == ParseStatus::Cancelled);
+    BOOST_CHECK_EQUAL(handler.records, 0);
+    
+    token.reset();
+    handler.stopAt = -1;
+    BOOST_CHECK(parser.parse(xml.data(), xml.size(), "feed.xml", handler));
+}
+
+/**
+ A static handler that only wants text, so it never sees elements itself.
+ */
+struct TextCounter {
+    std::size_t length = 0;
+    
+    void characters(const char* chars, std::size_t length) {
+        this->length += length;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(budgetTest) {
+    std::string xml = makeFeed(100000);
+    RecordCounter handler;
+    
+    ParseOptions options;
+    options.maxBytes = xml.size() / 2;
+    Parser bytesParser(options);
+    BOOST_CHECK(!bytesParser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(bytesParser.status() == ParseStatus::MaxBytes);
+    
+    options = ParseOptions();
+    options.maxBytes = xml.size();
+    Parser exactParser(options);
+    BOOST_CHECK(exactParser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    
+    // The feed, then records and values alternate
+    options = ParseOptions();
+    options.maxElements = 21;
+    Parser elementsParser(options);
+    handler.records = 0;
+    BOOST_CHECK(!elementsParser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(elementsParser.status() == ParseStatus::MaxElements);
+    BOOST_CHECK_EQUAL(handler.records, 10);
+    
+    options = ParseOptions();
+    options.maxDepth = 2;
+    Parser depthParser(options);
+    BOOST_CHECK(!depthParser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(depthParser.status() == ParseStatus::MaxDepth);
+    options.maxDepth = 3;
+    Parser deepEnoughParser(options);
+    BOOST_CHECK(deepEnoughParser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    
+    options = ParseOptions();
+    options.timeout = std::chrono::milliseconds(1);
+    Parser timeoutParser(options);
+    handler.records = 0;
+    handler.sleepAt = 0;
+    BOOST_CHECK(!timeoutParser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(timeoutParser.status() == ParseStatus::Timeout);
+    BOOST_CHECK_LT(handler.records, 100000);
+}
+
+BOOST_AUTO_TEST_CASE(textOnlyBudgetTest) {
+    std::string xml = makeFeed(100000);
+    TextCounter handler;
+    
+    ParseOptions options;
+    options.maxElements = 21;
+    Parser elementsParser(options);
+    BOOST_CHECK(!elementsParser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(elementsParser.status() == ParseStatus::MaxElements);
+    BOOST_CHECK_LT(handler.length, 100u);
+    
+    options = ParseOptions();
+    options.maxDepth = 2;
+    Parser depthParser(options);
+    BOOST_CHECK(!depthParser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    BOOST_CHECK(depthParser.status() == ParseStatus::MaxDepth);
+}
+
+BOOST_AUTO_TEST_CASE(freeFunctionStatusTest) {
+    std::string xml = makeFeed(100);
+    RecordCounter handler;
+    ParseStatus status = ParseStatus::Error;
+    BOOST_CHECK(parse(xml.data(), xml.size(), "feed.xml", handler, ParseOptions(), &status));
+    BOOST_CHECK(status == ParseStatus::Ok);
+    
+    ParseOptions options;
+    options.maxDepth = 2;
+    BOOST_CHECK(!parse(xml.data(), xml.size(), "feed.xml", handler, options, &status));
+    BOOST_CHECK(status == ParseStatus::MaxDepth);
+    
+    handler.records = 0;
+    handler.stopAt = 5;
+    std::istringstream stream(xml);
+    BOOST_CHECK(!parse(stream, "feed.xml", handler, ParseOptions(), &status));
+    BOOST_CHECK(status == ParseStatus::Stopped);
+    
+    TextCounter textHandler;
+    options = ParseOptions();
+    options.maxElements = 3;
+    BOOST_CHECK(!parse(xml.data(), xml.size(), "feed.xml", textHandler, options, &status));
+    BOOST_CHECK(status == ParseStatus::MaxElements);
+    
+    BOOST_CHECK(!parseFile("missing.xml", handler, ParseOptions(), &status));
+    BOOST_CHECK(status == ParseStatus::Error);
+}
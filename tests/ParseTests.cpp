@@ -20,6 +20,9 @@
 
 #include <lxml/lxml.h>
 #include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <sstream>
 
 using namespace lxml;
@@ -38,7 +41,7 @@ public:
     void startDocument() {}
     void endDocument() {}
     
-    void startElement(const QName& qname, const NamespaceMap& namespaces, const AttributeMap& attributes) {
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
         elementCount += 1;
     }
     void endElement(const QName& qname) {}
@@ -49,6 +52,15 @@ public:
     }
 };
 
+static const char* kNoteXML =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<note>\n"
+    "  <to>Tove</to>\n"
+    "  <from>Jani</from>\n"
+    "  <heading>Reminder</heading>\n"
+    "  <body>Don't forget me this weekend!</body>\n"
+    "</note>\n";
+
 
 BOOST_AUTO_TEST_CASE(parseTest) {
     // Test XML
@@ -70,3 +82,31 @@ BOOST_AUTO_TEST_CASE(parseTest) {
     BOOST_CHECK_EQUAL(handler.elementCount, 5);
     BOOST_CHECK_EQUAL(handler.errorCount, 0);
 }
+
+BOOST_AUTO_TEST_CASE(parseMemoryTest) {
+    CountHandler handler;
+    bool result = parse(kNoteXML, std::strlen(kNoteXML), "memory", handler);
+
+    BOOST_CHECK(result);
+    BOOST_CHECK_EQUAL(handler.elementCount, 5);
+    BOOST_CHECK_EQUAL(handler.errorCount, 0);
+}
+
+BOOST_AUTO_TEST_CASE(parseFileTest) {
+    static const char* path = "lxml_parse_file_test.xml";
+    {
+        std::ofstream file(path);
+        file << kNoteXML;
+    }
+
+    CountHandler handler;
+    bool result = parseFile(path, handler);
+    std::remove(path);
+
+    BOOST_CHECK(result);
+    BOOST_CHECK_EQUAL(handler.elementCount, 5);
+    BOOST_CHECK_EQUAL(handler.errorCount, 0);
+
+    CountHandler missingHandler;
+    BOOST_CHECK(!parseFile("lxml_missing_file.xml", missingHandler));
+}
@@ -0,0 +1,238 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/ListHandler.h>
+#include <lxml/StringHandler.h>
+#include <lxml/Wait.h>
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lxml;
+
+/**
+ A handler that counts elements and checks whether names are interned.
+ */
+class InternCountHandler : public SAXHandler {
+public:
+    int elementCount;
+    bool allInterned;
+    
+public:
+    InternCountHandler() : elementCount(0), allInterned(true) {}
+    
+    void startDocument() {}
+    void endDocument() {}
+    
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        elementCount += 1;
+        allInterned = allInterned && qname.isInterned();
+    }
+    void endElement(const QName& qname) {}
+    
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+static std::string makeList(int count) {
+    std::string xml = "<list>";
+    for (int i = 0; i < count; i += 1)
+        xml += "<item>" + std::to_string(i) + "</item>";
+    xml += "</list>";
+    return xml;
+}
+
+/**
+ A stream buffer for a list that never ends.
+ */
+class EndlessListBuffer : public std::streambuf {
+public:
+    EndlessListBuffer() : _chunk("<list>") {
+        setg(&_chunk[0], &_chunk[0], &_chunk[0] + _chunk.size());
+    }
+    
+protected:
+    int_type underflow() {
+        _chunk = "<item>0</item>";
+        setg(&_chunk[0], &_chunk[0], &_chunk[0] + _chunk.size());
+        return traits_type::to_int_type(_chunk[0]);
+    }
+    
+private:
+    std::string _chunk;
+};
+
+/**
+ An input source that delivers a list start and then blocks until it is
+ cancelled, like a socket that stops sending.
+ */
+class StalledSource : public InputSource {
+public:
+    StalledSource() : _started(), _cancelled() {}
+    
+    std::size_t read(char* buffer, std::size_t size) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_started) {
+            _started = true;
+            std::size_t length = std::min<std::size_t>(size, 6);
+            std::memcpy(buffer, "<list>", length);
+            return length;
+        }
+        waitUntil(_condition, lock, [this]() { return _cancelled; });
+        return 0;
+    }
+    
+    void cancel() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cancelled = true;
+        _condition.notify_all();
+    }
+    
+    bool cancelled() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _cancelled;
+    }
+    
+private:
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _started;
+    bool _cancelled;
+};
+
+
+BOOST_AUTO_TEST_CASE(parserReuseTest) {
+    static const char* kBrokenXML = "<list><item></list>";
+    
+    Parser parser;
+    for (int i = 1; i <= 10; i += 1) {
+        std::string xml = makeList(i);
+        InternCountHandler handler;
+        BOOST_CHECK(parser.parse(xml.data(), xml.size(), "list", handler));
+        BOOST_CHECK_EQUAL(handler.elementCount, i + 1);
+        
+        // A failed document must not affect the next one
+        InternCountHandler brokenHandler;
+        BOOST_CHECK(!parser.parse(kBrokenXML, std::strlen(kBrokenXML), "broken", brokenHandler));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parserRecursiveReuseTest) {
+    StringHandler itemHandler;
+    ListHandler<std::string> listHandler(itemHandler);
+    
+    Parser parser;
+    for (int i = 1; i <= 3; i += 1) {
+        std::string xml = makeList(i);
+        BOOST_CHECK(parser.parse(xml.data(), xml.size(), "list", listHandler));
+        
+        const std::vector<std::string>& items = listHandler.result();
+        BOOST_REQUIRE_EQUAL(items.size(), i);
+        BOOST_CHECK_EQUAL(items.back(), std::to_string(i - 1));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parserPoolTest) {
+    // Names are interned when they are registered in the shared table
+    SymbolTable symbols;
+    symbols.intern("list");
+    symbols.intern("item");
+    ParseOptions options;
+    options.symbols = &symbols;
+    ParserPool pool(options);
+    std::atomic<int> failures(0);
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t += 1) {
+        threads.emplace_back([&pool, &failures]() {
+            for (int i = 1; i <= 50; i += 1) {
+                std::string xml = makeList(i);
+                InternCountHandler handler;
+                Parser& parser = pool.local();
+                if (!parser.parse(xml.data(), xml.size(), "list", handler) || handler.elementCount != i + 1 || !handler.allInterned)
+                    failures += 1;
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    
+    BOOST_CHECK_EQUAL(failures, 0);
+    BOOST_CHECK_EQUAL(pool.size(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(readAheadTest) {
+    ParseOptions options;
+    options.readAhead = true;
+    options.readAheadBufferSize = 4096;
+    options.readAheadDepth = 3;
+    Parser parser(options);
+    
+    std::string xml = makeList(10000);
+    std::istringstream stream(xml);
+    InternCountHandler handler;
+    BOOST_CHECK(parser.parse(stream, "list", handler));
+    BOOST_CHECK_EQUAL(handler.elementCount, 10001);
+    
+    const ReadAheadStats& stats = parser.readAheadStats();
+    BOOST_CHECK_EQUAL(stats.bytes, xml.size());
+    BOOST_CHECK_EQUAL(stats.buffers, (xml.size() + 4095) / 4096);
+    
+    // Stop reading ahead when parsing fails
+    std::istringstream broken("<list><item></list>" + xml);
+    BOOST_CHECK(!parser.parse(broken, "list", handler));
+}
+
+BOOST_AUTO_TEST_CASE(readAheadEarlyStopTest) {
+    // Stopping early waits for the read in progress, which returns because
+    // the stream always has more data
+    ParseOptions options;
+    options.readAhead = true;
+    options.readAheadBufferSize = 4096;
+    options.maxElements = 1000;
+    Parser parser(options);
+    
+    EndlessListBuffer buffer;
+    std::istream stream(&buffer);
+    InternCountHandler handler;
+    BOOST_CHECK(!parser.parse(stream, "list", handler));
+    BOOST_CHECK(parser.status() == ParseStatus::MaxElements);
+    
+    // A source that stalls is cancelled
+    StalledSource source;
+    {
+        ReadAhead reader(source, 6, 2);
+        const char* data;
+        std::size_t length;
+        BOOST_REQUIRE(reader.next(data, length));
+        BOOST_CHECK_EQUAL(std::string(data, length), "<list>");
+    }
+    BOOST_CHECK(source.cancelled());
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/PathSelector.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace lxml;
+
+static const char* kFeedXML =
+    "<feed>\n"
+    "  <entry><id>1</id><link rel='alternate' href='a.html'/><link rel='self' href='a.xml'/>\n"
+    "    <price currency='EUR'>10</price></entry>\n"
+    "  <entry><id>2</id><meta><id>nested</id><price>20</price></meta></entry>\n"
+    "  <entry><id>3</id><title>x<b>y</b>z</title></entry>\n"
+    "</feed>\n";
+
+/**
+ Collects the values of every match as `path:value`.
+ */
+struct Collector {
+    std::vector<std::string> values;
+    
+    PathSelector::Callback callback() {
+        return [this](const PathMatch& match) {
+            values.push_back(std::to_string(match.path) + ":" + std::string(match.value));
+        };
+    }
+};
+
+static std::vector<std::string> select(const std::vector<std::string>& paths) {
+    Collector collector;
+    PathSelector selector;
+    for (const std::string& path : paths)
+        BOOST_CHECK_NE(selector.add(path, collector.callback()), PathSelector::npos);
+    BOOST_CHECK(parse(kFeedXML, std::strlen(kFeedXML), "feed.xml", selector));
+    return collector.values;
+}
+
+BOOST_AUTO_TEST_CASE(pathSelectorChildTest) {
+    std::vector<std::string> values = select({"/feed/entry/id"});
+    std::vector<std::string> expected = {"0:1", "0:2", "0:3"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), expected.begin(), expected.end());
+    
+    // Element values include the text of descendants
+    values = select({"/feed/entry/title", "/feed/*/title/b"});
+    expected = {"1:y", "0:xyz"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(pathSelectorDescendantTest) {
+    std::vector<std::string> values = select({"//price[@currency]", "//id", "/feed//meta/price"});
+    std::vector<std::string> expected = {"1:1", "0:10", "1:2", "1:nested", "2:20", "1:3"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(pathSelectorAttributeTest) {
+    std::vector<std::string> values = select({"/feed/entry/link/@href", "/feed/entry/link[@rel='self']/@*", "//@currency"});
+    std::vector<std::string> expected = {"0:a.html", "0:a.xml", "1:self", "1:a.xml", "2:EUR"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(values.begin(), values.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(pathSelectorMalformedTest) {
+    PathSelector selector;
+    auto callback = [](const PathMatch&) {};
+    BOOST_CHECK_EQUAL(selector.add("feed/entry", callback), PathSelector::npos);
+    BOOST_CHECK_EQUAL(selector.add("/feed/", callback), PathSelector::npos);
+    BOOST_CHECK_EQUAL(selector.add("/@id", callback), PathSelector::npos);
+    BOOST_CHECK_EQUAL(selector.add("/feed/@id/x", callback), PathSelector::npos);
+    BOOST_CHECK_EQUAL(selector.add("/feed[@a='b]", callback), PathSelector::npos);
+    BOOST_CHECK_EQUAL(selector.add("/atom:feed", callback), PathSelector::npos);
+    BOOST_CHECK_EQUAL(selector.size(), 0u);
+    BOOST_CHECK_EQUAL(selector.add("//entry[@a][@b=\"c\"]", callback), 0u);
+}
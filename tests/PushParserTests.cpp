@@ -0,0 +1,162 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/PushParser.h>
+#include <lxml/BaseRecursiveHandler.h>
+#include <lxml/StringHandler.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace lxml;
+
+static const char* kFeedXML =
+    "<?xml version='1.0'?>\n"
+    "<feed>\n"
+    "  <record>first</record>\n"
+    "  <record>second <b>bold</b></record>\n"
+    "  <record><![CDATA[third]]></record>\n"
+    "</feed>\n";
+
+/**
+ Collects the text of every record.
+ */
+class FeedHandler : public BaseRecursiveHandler<std::vector<std::string>> {
+public:
+    StringHandler record;
+    
+public:
+    void startElement(const QName& qname, const AttributeView& attributes) {
+        _result.clear();
+    }
+    RecursiveHandler* startSubElement(const QName& qname) {
+        return &record;
+    }
+    void endSubElement(const QName& qname, RecursiveHandler* handler) {
+        _result.push_back(record.result());
+    }
+};
+
+/**
+ Counts elements and stops at a given one.
+ */
+class CountingHandler : public SAXHandler {
+public:
+    int elements = 0;
+    int stopAt = -1;
+    
+public:
+    void startDocument() {}
+    void endDocument() {}
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        if (++elements == stopAt)
+            ParseContext::current()->stop();
+    }
+    void endElement(const QName& qname) {}
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+BOOST_AUTO_TEST_CASE(pushParserFragmentsTest) {
+    std::string xml = kFeedXML;
+    std::size_t firstRecordEnd = xml.find("</record>") + std::strlen("</record>");
+    
+    PushParser parser;
+    for (std::size_t fragment = 1; fragment < 8; ++fragment) {
+        FeedHandler handler;
+        BOOST_CHECK(parser.begin("feed.xml", handler));
+        
+        std::size_t records = 0;
+        for (std::size_t offset = 0; offset < xml.size(); offset += fragment) {
+            std::size_t length = std::min(fragment, xml.size() - offset);
+            BOOST_CHECK(parser.feed(xml.data() + offset, length));
+            
+            // Records are reported as soon as their end tag has been parsed
+            BOOST_CHECK_GE(parser.recordCount(), records);
+            records = parser.recordCount();
+            BOOST_CHECK_EQUAL(handler.result().size(), records);
+            if (offset + length < firstRecordEnd)
+                BOOST_CHECK_EQUAL(records, 0u);
+        }
+        BOOST_CHECK(parser.finish());
+        BOOST_CHECK(!parser.active());
+        BOOST_CHECK_EQUAL(parser.recordCount(), 3u);
+        
+        std::vector<std::string> expected = {"first", "second", "third"};
+        BOOST_CHECK_EQUAL_COLLECTIONS(handler.result().begin(), handler.result().end(), expected.begin(), expected.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pushParserSAXTest) {
+    PushParser parser;
+    CountingHandler handler;
+    BOOST_CHECK(parser.begin("feed.xml", handler));
+    BOOST_CHECK(parser.feed(kFeedXML, std::strlen(kFeedXML)));
+    BOOST_CHECK(parser.finish());
+    BOOST_CHECK_EQUAL(handler.elements, 5);
+    BOOST_CHECK_EQUAL(parser.recordCount(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(pushParserErrorTest) {
+    PushParser parser;
+    FeedHandler handler;
+    
+    // Not started
+    BOOST_CHECK(!parser.feed("<feed/>", 7));
+    
+    // Incomplete documents fail when finished
+    static const char* kTruncated = "<feed><record>a</record>";
+    BOOST_CHECK(parser.begin("truncated.xml", handler));
+    BOOST_CHECK(parser.feed(kTruncated, std::strlen(kTruncated)));
+    BOOST_CHECK(!parser.finish());
+    BOOST_CHECK(parser.failed());
+    BOOST_CHECK(parser.status() == ParseStatus::Error);
+    
+    // Errors stick until the next document
+    static const char* kInvalid = "<feed><record></feed>";
+    BOOST_CHECK(parser.begin("invalid.xml", handler));
+    BOOST_CHECK(!parser.feed(kInvalid, std::strlen(kInvalid)));
+    BOOST_CHECK(!parser.feed("</record>", 9));
+    BOOST_CHECK(!parser.finish());
+    
+    BOOST_CHECK(parser.begin("feed.xml", handler));
+    BOOST_CHECK(!parser.failed());
+    BOOST_CHECK(parser.feed(kFeedXML, std::strlen(kFeedXML)));
+    BOOST_CHECK(parser.finish());
+    BOOST_CHECK_EQUAL(handler.result().size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(pushParserStopTest) {
+    PushParser parser;
+    CountingHandler handler;
+    handler.stopAt = 2;
+    BOOST_CHECK(parser.begin("feed.xml", handler));
+    BOOST_CHECK(!parser.feed(kFeedXML, std::strlen(kFeedXML)));
+    BOOST_CHECK(!parser.finish());
+    BOOST_CHECK(parser.failed());
+    BOOST_CHECK(parser.status() == ParseStatus::Stopped);
+    BOOST_CHECK_EQUAL(handler.elements, 2);
+    
+    handler.stopAt = -1;
+    BOOST_CHECK(parser.begin("feed.xml", handler));
+    BOOST_CHECK(parser.status() == ParseStatus::Ok);
+}
@@ -0,0 +1,150 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/IntegerHandler.h>
+#include <lxml/RouterHandler.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+using namespace lxml;
+
+static const char* kPersonXML =
+    "<person>\n"
+    "  <name> Ada </name>\n"
+    "  <unknown><name>ignored</name></unknown>\n"
+    "  <age>36</age>\n"
+    "</person>\n";
+
+static const char* kIncompletePersonXML =
+    "<person><email>ada@example.com</email></person>";
+
+struct Person {
+    std::string name;
+    std::string email;
+    int age;
+    bool complete;
+    
+    Person() : age(), complete() {}
+};
+
+/**
+ A router that fills a Person and checks for required fields.
+ */
+class PersonHandler : public RouterHandler<Person> {
+public:
+    PersonHandler(const QName& name, const QName& age, const QName& email) {
+        routeText(name, [this](std::string_view text) { _result.name.assign(text.data(), text.size()); }, true);
+        routeText(email, [this](std::string_view text) { _result.email.assign(text.data(), text.size()); });
+        route<IntegerHandler>(age, _ageHandler, [this](IntegerHandler& handler) { _result.age = handler.result(); }, true);
+    }
+    
+    void startElement(const QName& qname, const AttributeView& attributes) {
+        RouterHandler<Person>::startElement(qname, attributes);
+        reset();
+    }
+    
+    void endElement(const QName& qname, std::string_view contents) {
+        _result.complete = hasRequired();
+    }
+    
+private:
+    IntegerHandler _ageHandler;
+};
+
+/**
+ A router for nested sections that routes sections to itself and records
+ whether each section had its required title, innermost first.
+ */
+class SectionHandler : public RouterHandler<std::vector<bool>> {
+public:
+    SectionHandler() {
+        routeText("title", [](std::string_view text) {}, true);
+        route<SectionHandler>("section", *this);
+    }
+    
+    void endElement(const QName& qname, std::string_view contents) {
+        _result.push_back(hasRequired());
+    }
+};
+
+
+BOOST_AUTO_TEST_CASE(routerTest) {
+    PersonHandler handler("name", "age", "email");
+    bool result = parse(kPersonXML, std::strlen(kPersonXML), "person", handler);
+    
+    BOOST_CHECK(result);
+    BOOST_CHECK_EQUAL(handler.result().name, "Ada");
+    BOOST_CHECK_EQUAL(handler.result().age, 36);
+    BOOST_CHECK(handler.result().email.empty());
+    BOOST_CHECK(handler.result().complete);
+    BOOST_CHECK(!handler.seen(1));
+}
+
+BOOST_AUTO_TEST_CASE(recursiveRouterTest) {
+    static const char* kSectionsXML =
+        "<section>\n"
+        "  <title>Outer</title>\n"
+        "  <section><section><title>Inner</title></section></section>\n"
+        "</section>\n";
+    
+    SectionHandler handler;
+    BOOST_CHECK(parse(kSectionsXML, std::strlen(kSectionsXML), "sections", handler));
+    
+    std::vector<bool> expected = {true, false, true};
+    BOOST_CHECK(handler.result() == expected);
+}
+
+BOOST_AUTO_TEST_CASE(internedRouterTest) {
+    SymbolTable symbols;
+    PersonHandler handler(symbols.intern("name"), symbols.intern("age"), symbols.intern("email"));
+    
+    ParseOptions options;
+    options.symbols = &symbols;
+    bool result = parse(kIncompletePersonXML, std::strlen(kIncompletePersonXML), "person", handler, options);
+    
+    BOOST_CHECK(result);
+    BOOST_CHECK_EQUAL(handler.result().email, "ada@example.com");
+    BOOST_CHECK(!handler.result().complete);
+    
+    std::vector<QName> missing = handler.missingRequired();
+    BOOST_REQUIRE_EQUAL(missing.size(), 2);
+    BOOST_CHECK(missing[0] == QName("name"));
+    BOOST_CHECK(missing[1] == QName("age"));
+}
+
+BOOST_AUTO_TEST_CASE(routeTableTest) {
+    std::deque<std::string> names;
+    RouteTable table;
+    for (int i = 0; i < 200; i += 1) {
+        names.push_back("field" + std::to_string(i));
+        table.insert(QName(names.back().c_str()));
+    }
+    
+    BOOST_CHECK_EQUAL(table.size(), 200);
+    BOOST_CHECK_EQUAL(table.find(QName("field0")), 0);
+    BOOST_CHECK_EQUAL(table.find(QName("field199")), 199);
+    BOOST_CHECK_EQUAL(table.find(QName("field200")), RouteTable::npos);
+    BOOST_CHECK_EQUAL(table.insert(QName("field7")), 7);
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/BaseRecursiveHandler.h>
+#include <lxml/ParseContext.h>
+#include <lxml/Parser.h>
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using namespace lxml;
+
+static const char* kSkipXML =
+    "<root>\n"
+    "  <keep>a</keep>\n"
+    "  <skip id='1'>b<keep>c</keep><skip>d<skip/></skip><!-- e --><![CDATA[f]]></skip>\n"
+    "  <skip/>\n"
+    "  <keep>g</keep>\n"
+    "</root>\n";
+
+/**
+ A SAX handler that skips every `skip` element and records what it sees.
+ */
+class SkippingHandler : public SAXHandler {
+public:
+    std::string events;
+    
+public:
+    void startDocument() {}
+    void endDocument() {}
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        events += "<" + std::string(qname.localName()) + ">";
+        if (std::strcmp(qname.localName(), "skip") == 0)
+            ParseContext::current()->skipSubtree();
+    }
+    void endElement(const QName& qname) {
+        events += "</" + std::string(qname.localName()) + ">";
+    }
+    void characters(const char* chars, std::size_t length) {
+        for (std::size_t i = 0; i < length; ++i) {
+            if (chars[i] != ' ' && chars[i] != '\n')
+                events += chars[i];
+        }
+    }
+    void error(const xmlError& error) {
+        events += "!";
+    }
+};
+
+/**
+ The same handler without virtual dispatch.
+ */
+struct StaticSkippingHandler {
+    std::string events;
+    
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        events += "<" + std::string(qname.localName()) + ">";
+        if (std::strcmp(qname.localName(), "skip") == 0)
+            ParseContext::current()->skipSubtree();
+    }
+    void endElement(const QName& qname) {
+        events += "</" + std::string(qname.localName()) + ">";
+    }
+};
+
+static const char* kSkippedEvents = "<root><keep>a</keep><skip></skip><skip></skip><keep>g</keep></root>";
+
+BOOST_AUTO_TEST_CASE(skipSubtreeTest) {
+    SkippingHandler handler;
+    bool success = parse(kSkipXML, std::strlen(kSkipXML), "skip.xml", handler);
+    BOOST_CHECK(success);
+    BOOST_CHECK_EQUAL(handler.events, kSkippedEvents);
+    
+    StaticSkippingHandler staticHandler;
+    success = parse(kSkipXML, std::strlen(kSkipXML), "skip.xml", staticHandler);
+    BOOST_CHECK(success);
+    BOOST_CHECK_EQUAL(staticHandler.events, "<root><keep></keep><skip></skip><skip></skip><keep></keep></root>");
+}
+
+BOOST_AUTO_TEST_CASE(skipAcrossDocumentsTest) {
+    // A document that fails while skipping must not affect the next one
+    static const char* kBrokenXML = "<root><skip><a></b></skip></root>";
+    
+    Parser parser;
+    SkippingHandler handler;
+    BOOST_CHECK(!parser.parse(kBrokenXML, std::strlen(kBrokenXML), "broken.xml", handler));
+    
+    handler.events.clear();
+    BOOST_CHECK(parser.parse(kSkipXML, std::strlen(kSkipXML), "skip.xml", handler));
+    BOOST_CHECK_EQUAL(handler.events, kSkippedEvents);
+}
+
+/**
+ A recursive handler that keeps `keep` elements and ignores everything else.
+ */
+class KeepHandler : public BaseRecursiveHandler<std::string> {
+public:
+    BaseRecursiveHandler<std::string> child;
+    int ignored;
+    
+public:
+    KeepHandler() : ignored() {}
+    
+    void startElement(const QName& qname, const AttributeView& attributes) {
+        _result.clear();
+        ignored = 0;
+    }
+    RecursiveHandler* startSubElement(const QName& qname) {
+        if (std::strcmp(qname.localName(), "keep") == 0)
+            return &child;
+        return 0;
+    }
+    void endSubElement(const QName& qname, RecursiveHandler* handler) {
+        if (handler)
+            _result += "[" + std::string(qname.localName()) + "]";
+        else
+            ++ignored;
+    }
+    void endElement(const QName& qname, std::string_view contents) {
+        _result += std::string(contents);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(skipIgnoredSubElementTest) {
+    KeepHandler handler;
+    bool success = parse(kSkipXML, std::strlen(kSkipXML), "skip.xml", handler);
+    BOOST_CHECK(success);
+    BOOST_CHECK_EQUAL(handler.ignored, 2);
+    
+    // Text inside skipped subtrees never reaches the root's contents
+    std::string result = handler.result();
+    result.erase(std::remove_if(result.begin(), result.end(), [](char c) { return c == ' ' || c == '\n'; }), result.end());
+    BOOST_CHECK_EQUAL(result, "[keep][keep]");
+}
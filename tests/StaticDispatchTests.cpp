@@ -0,0 +1,113 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+
+using namespace lxml;
+
+static const char* kNoteXML =
+    "<note>\n"
+    "  <to>Tove</to>\n"
+    "  <from>Jani</from>\n"
+    "</note>\n";
+
+/**
+ A statically dispatched handler that only counts elements.
+ */
+class StaticCountHandler {
+public:
+    int elementCount;
+    
+public:
+    StaticCountHandler() : elementCount(0) {}
+    
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        elementCount += 1;
+    }
+};
+
+/**
+ A statically dispatched handler that collects text and counts errors.
+ */
+class StaticTextHandler {
+public:
+    std::string text;
+    int depth;
+    int errorCount;
+    
+public:
+    StaticTextHandler() : depth(0), errorCount(0) {}
+    
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        depth += 1;
+    }
+    void endElement(const QName& qname) {
+        depth -= 1;
+    }
+    void characters(const char* chars, std::size_t length) {
+        if (depth == 2)
+            text.append(chars, length);
+    }
+    void error(const xmlError& error) {
+        errorCount += 1;
+    }
+};
+
+
+BOOST_AUTO_TEST_CASE(staticDispatchTest) {
+    StaticCountHandler countHandler;
+    BOOST_CHECK(parse(kNoteXML, std::strlen(kNoteXML), "note", countHandler));
+    BOOST_CHECK_EQUAL(countHandler.elementCount, 3);
+    
+    StaticTextHandler textHandler;
+    BOOST_CHECK(parse(kNoteXML, std::strlen(kNoteXML), "note", textHandler));
+    BOOST_CHECK_EQUAL(textHandler.text, "ToveJani");
+    BOOST_CHECK_EQUAL(textHandler.depth, 0);
+    BOOST_CHECK_EQUAL(textHandler.errorCount, 0);
+}
+
+BOOST_AUTO_TEST_CASE(staticRegistrationTest) {
+    const xmlSAXHandler& countTable = StaticSAXHandler<StaticCountHandler>::table();
+    BOOST_CHECK(countTable.startElementNs != 0);
+    BOOST_CHECK(countTable.endElementNs == 0);
+    BOOST_CHECK(countTable.characters == 0);
+    
+    const xmlSAXHandler& textTable = StaticSAXHandler<StaticTextHandler>::table();
+    BOOST_CHECK(textTable.endElementNs != 0);
+    BOOST_CHECK(textTable.characters != 0);
+}
+
+BOOST_AUTO_TEST_CASE(staticErrorTest) {
+    static const char* kBrokenXML = "<note><to></note>";
+    
+    // Static and virtual handlers can share a parser
+    Parser parser;
+    StaticTextHandler handler;
+    BOOST_CHECK(!parser.parse(kBrokenXML, std::strlen(kBrokenXML), "broken", handler));
+    BOOST_CHECK(handler.errorCount > 0);
+    
+    StaticCountHandler countHandler;
+    BOOST_CHECK(parser.parse(kNoteXML, std::strlen(kNoteXML), "note", countHandler));
+    BOOST_CHECK_EQUAL(countHandler.elementCount, 3);
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace lxml;
+
+static const char* kMessagesXML =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<messages>\n"
+    "  <message priority=\"1\"><to>Tove</to><from>Jani</from></message>\n"
+    "  <message priority=\"2\"><to>Jani</to><from>Tove</from></message>\n"
+    "</messages>\n";
+
+/**
+ A handler that tests element names against pre-registered symbols.
+ */
+class SymbolHandler : public SAXHandler {
+public:
+    const QName message;
+    const QName to;
+    const QName priority;
+    
+    int messageCount;
+    int toCount;
+    int prioritySum;
+    bool internedIfRegistered;
+    
+public:
+    explicit SymbolHandler(SymbolTable& symbols)
+    : message(symbols.intern("message")), to(symbols.intern("to")), priority(symbols.intern("priority")),
+      messageCount(), toCount(), prioritySum(), internedIfRegistered(true) {}
+    
+    void startDocument() {}
+    void endDocument() {}
+    
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        // Only registered names can be compared by pointer
+        bool registered = std::strcmp(qname.localName(), "message") == 0 || std::strcmp(qname.localName(), "to") == 0;
+        internedIfRegistered = internedIfRegistered && qname.isInterned() == registered;
+        if (qname == message) {
+            messageCount += 1;
+            prioritySum += attributes.getInt(priority);
+        } else if (qname == to) {
+            toCount += 1;
+        }
+    }
+    void endElement(const QName& qname) {}
+    
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+
+BOOST_AUTO_TEST_CASE(symbolTableTest) {
+    SymbolTable symbols;
+    SymbolHandler handler(symbols);
+    
+    ParseOptions options;
+    options.symbols = &symbols;
+    bool result = parse(kMessagesXML, std::strlen(kMessagesXML), "messages", handler, options);
+    
+    BOOST_CHECK(result);
+    BOOST_CHECK(handler.internedIfRegistered);
+    BOOST_CHECK_EQUAL(handler.messageCount, 2);
+    BOOST_CHECK_EQUAL(handler.toCount, 2);
+    BOOST_CHECK_EQUAL(handler.prioritySum, 3);
+}
+
+BOOST_AUTO_TEST_CASE(internedQNameTest) {
+    SymbolTable symbols;
+    QName interned = symbols.intern("item", "urn:items");
+    QName plain("item", 0, "urn:items");
+    
+    BOOST_CHECK(interned.isInterned());
+    BOOST_CHECK(interned == plain);
+    BOOST_CHECK(interned == symbols.intern("item", "urn:items"));
+    BOOST_CHECK(interned != symbols.intern("item"));
+    BOOST_CHECK_EQUAL(interned.hash(), plain.hash());
+    
+    std::unordered_map<QName, int> map;
+    map[interned] = 1;
+    BOOST_CHECK_EQUAL(map.count(plain), 1);
+}
+
+/**
+ Keeps the names of elements.
+ */
+class NameHandler : public SAXHandler {
+public:
+    std::vector<QName> names;
+    
+public:
+    void startDocument() {}
+    void endDocument() {}
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {
+        names.push_back(qname);
+    }
+    void endElement(const QName& qname) {}
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+BOOST_AUTO_TEST_CASE(unregisteredNameTest) {
+    static const char* kXML = "<root><item/><other/></root>";
+    SymbolTable symbols;
+    symbols.intern("item");
+    
+    // Unregistered names come from each parser's own dictionary
+    ParseOptions options;
+    options.symbols = &symbols;
+    Parser first(options);
+    Parser second(options);
+    NameHandler firstNames;
+    NameHandler secondNames;
+    BOOST_REQUIRE(first.parse(kXML, std::strlen(kXML), "first", firstNames));
+    BOOST_REQUIRE(second.parse(kXML, std::strlen(kXML), "second", secondNames));
+    BOOST_REQUIRE_EQUAL(firstNames.names.size(), 3);
+    BOOST_REQUIRE_EQUAL(secondNames.names.size(), 3);
+    
+    const QName& firstItem = firstNames.names[1];
+    const QName& secondItem = secondNames.names[1];
+    BOOST_CHECK(firstItem.isInterned());
+    BOOST_CHECK_EQUAL(firstItem.localName(), secondItem.localName());
+    BOOST_CHECK(firstItem == secondItem);
+    
+    const QName& firstOther = firstNames.names[2];
+    const QName& secondOther = secondNames.names[2];
+    BOOST_CHECK(!firstOther.isInterned());
+    BOOST_CHECK(firstOther.localName() != secondOther.localName());
+    BOOST_CHECK(firstOther == secondOther);
+    BOOST_CHECK_EQUAL(firstOther.hash(), secondOther.hash());
+    
+    std::unordered_set<QName> set = {firstOther, secondOther, firstItem, secondItem};
+    BOOST_CHECK_EQUAL(set.size(), 2);
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <lxml/StringHandler.h>
+#include <lxml/Whitespace.h>
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+
+using namespace lxml;
+
+
+BOOST_AUTO_TEST_CASE(whitespaceTest) {
+    std::string string = "0123456789abcdefghijkl \t  \n  \r                   xyz";
+    const char* first = string.data();
+    const char* last = first + string.size();
+    for (std::size_t i = 0; i < string.size(); i += 1) {
+        std::size_t space = string.find_first_of(" \t\n\r", i);
+        std::size_t word = string.find_first_not_of(" \t\n\r", i);
+        BOOST_CHECK_EQUAL(findSpace(first + i, last) - first, space == std::string::npos ? string.size() : space);
+        BOOST_CHECK_EQUAL(skipSpace(first + i, last) - first, word == std::string::npos ? string.size() : word);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(trimTest) {
+    BOOST_CHECK_EQUAL(trim("  \t a  b \r\n"), "a  b");
+    BOOST_CHECK_EQUAL(trim("                    long enough to use blocks                    "), "long enough to use blocks");
+    BOOST_CHECK_EQUAL(trim(" \n "), "");
+    BOOST_CHECK_EQUAL(trim(""), "");
+    
+    std::string string = "\n  one   two\t\tthree                    four \n";
+    string.resize(normalize(&string[0], string.size()));
+    BOOST_CHECK_EQUAL(string, "one two three four");
+}
+
+BOOST_AUTO_TEST_CASE(stringHandlerModeTest) {
+    const char* xml = "<text>\n  Hello,\n    <b>ignored</b>  world  \n</text>";
+    
+    StringHandler handler(StringHandler::Mode::Raw);
+    BOOST_CHECK(parse(xml, std::strlen(xml), "text", handler));
+    BOOST_CHECK_EQUAL(handler.result(), "\n  Hello,\n      world  \n");
+    
+    handler.setMode(StringHandler::Mode::Trim);
+    BOOST_CHECK(parse(xml, std::strlen(xml), "text", handler));
+    BOOST_CHECK_EQUAL(handler.result(), "Hello,\n      world");
+    
+    handler.setMode(StringHandler::Mode::Normalize);
+    BOOST_CHECK(parse(xml, std::strlen(xml), "text", handler));
+    BOOST_CHECK_EQUAL(handler.result(), "Hello, world");
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/lxml.h>
+#include <boost/test/unit_test.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lxml;
+
+static std::string makeDocument(int records) {
+    std::string xml = "<feed xmlns='urn:feed'>";
+    for (int i = 0; i < records; ++i)
+        xml += "<record id='" + std::to_string(i) + "' name='record number " + std::to_string(i) + "'><value>" + std::to_string(i) + "</value></record>";
+    xml += "</feed>";
+    return xml;
+}
+
+class NullHandler : public SAXHandler {
+public:
+    void startDocument() {}
+    void endDocument() {}
+    void startElement(const QName& qname, const NamespaceView& namespaces, const AttributeView& attributes) {}
+    void endElement(const QName& qname) {}
+    void characters(const char* chars, std::size_t length) {}
+    void error(const xmlError& error) {}
+};
+
+BOOST_AUTO_TEST_CASE(poolAllocationTest) {
+    const std::size_t sizes[] = {0, 1, 16, 17, 100, 4096, XmlMemoryPool::kMaxPooledSize, XmlMemoryPool::kMaxPooledSize + 1};
+    for (std::size_t size : sizes) {
+        char* block = static_cast<char*>(XmlMemoryPool::allocate(size));
+        BOOST_REQUIRE(block);
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(block) % 16, 0u);
+        std::memset(block, 'x', size);
+        XmlMemoryPool::free(block);
+    }
+    
+    // Growing keeps the contents, across size classes and out of the pool
+    char* block = static_cast<char*>(XmlMemoryPool::allocate(10));
+    std::memcpy(block, "123456789", 10);
+    block = static_cast<char*>(XmlMemoryPool::reallocate(block, 12));
+    BOOST_CHECK_EQUAL(block, "123456789");
+    block = static_cast<char*>(XmlMemoryPool::reallocate(block, 1000));
+    BOOST_CHECK_EQUAL(block, "123456789");
+    block = static_cast<char*>(XmlMemoryPool::reallocate(block, 100000));
+    BOOST_CHECK_EQUAL(block, "123456789");
+    XmlMemoryPool::free(block);
+    
+    // Memory from malloc is left to malloc
+    char* foreign = static_cast<char*>(std::malloc(32));
+    std::strcpy(foreign, "foreign");
+    foreign = static_cast<char*>(XmlMemoryPool::reallocate(foreign, 64));
+    BOOST_CHECK_EQUAL(foreign, "foreign");
+    XmlMemoryPool::free(foreign);
+    
+    char* copy = XmlMemoryPool::duplicate("duplicate");
+    BOOST_CHECK_EQUAL(copy, "duplicate");
+    XmlMemoryPool::free(copy);
+    XmlMemoryPool::free(0);
+}
+
+BOOST_AUTO_TEST_CASE(poolRecycleTest) {
+    BOOST_REQUIRE(XmlMemoryPool::install());
+    BOOST_CHECK(XmlMemoryPool::install());
+    BOOST_CHECK(XmlMemoryPool::installed());
+    
+    std::string xml = makeDocument(2000);
+    Parser parser;
+    NullHandler handler;
+    BOOST_CHECK(parser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    XmlMemoryStats first = XmlMemoryPool::stats();
+    BOOST_CHECK_GT(first.allocations, 0u);
+    BOOST_CHECK_GT(first.reservedBytes, 0u);
+    
+    // Later documents reuse the blocks of the first
+    for (int i = 0; i < 5; ++i)
+        BOOST_CHECK(parser.parse(xml.data(), xml.size(), "feed.xml", handler));
+    XmlMemoryStats later = XmlMemoryPool::stats();
+    BOOST_CHECK_GT(later.allocations, first.allocations);
+    BOOST_CHECK_GT(later.frees, first.frees);
+    BOOST_CHECK_EQUAL(later.reservedBytes, first.reservedBytes);
+    BOOST_CHECK_EQUAL(later.bytesInUse, first.bytesInUse);
+}
+
+BOOST_AUTO_TEST_CASE(poolThreadTest) {
+    BOOST_REQUIRE(XmlMemoryPool::install());
+    std::string xml = makeDocument(2000);
+    
+    auto round = [&]() {
+        std::vector<std::thread> threads;
+        std::vector<int> parsed(4);
+        for (std::size_t t = 0; t < parsed.size(); ++t) {
+            threads.emplace_back([&, t]() {
+                Parser parser;
+                NullHandler handler;
+                for (int i = 0; i < 10; ++i)
+                    parsed[t] += parser.parse(xml.data(), xml.size(), "feed.xml", handler);
+            });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        for (int count : parsed)
+            BOOST_CHECK_EQUAL(count, 10);
+    };
+    
+    round();
+    XmlMemoryStats first = XmlMemoryPool::stats();
+    
+    // The exited threads' blocks went back to the depot for the next ones
+    round();
+    XmlMemoryStats second = XmlMemoryPool::stats();
+    BOOST_CHECK_GT(second.frees, first.frees);
+    BOOST_CHECK_EQUAL(second.reservedBytes, first.reservedBytes);
+}
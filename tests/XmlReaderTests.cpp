@@ -0,0 +1,158 @@
+// Copyright (c) 2014 Venture Media Labs, Inc.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+
+
+#include <lxml/XmlReader.h>
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+using namespace lxml;
+
+static const char* kLibraryXML =
+    "<library name='city'>\n"
+    "  <book id='1' lang='en'><title>One</title><notes>a <b>b</b> c</notes></book>\n"
+    "  <book id='2'><title>Two</title></book>\n"
+    "</library>\n";
+
+/**
+ Write every event as a compact string.
+ */
+static std::string readAll(XmlReader& reader) {
+    std::string events;
+    while (reader.read()) {
+        switch (reader.event()) {
+            case XmlEvent::StartElement:
+                events += "<" + std::string(reader.name().localName());
+                for (Attribute attribute : reader.attributes())
+                    events += " " + std::string(attribute.localName()) + "=" + std::string(attribute.value());
+                events += ">";
+                break;
+            case XmlEvent::EndElement:
+                events += "</" + std::string(reader.name().localName()) + ">";
+                break;
+            case XmlEvent::Text:
+                if (reader.text().find_first_not_of(" \n") != std::string_view::npos)
+                    events += std::string(reader.text());
+                break;
+            default:
+                break;
+        }
+    }
+    return events;
+}
+
+static const char* kLibraryEvents =
+    "<library name=city><book id=1 lang=en><title>One</title><notes>a <b>b</b> c</notes></book>"
+    "<book id=2><title>Two</title></book></library>";
+
+BOOST_AUTO_TEST_CASE(xmlReaderEventsTest) {
+    XmlReader reader;
+    BOOST_CHECK(reader.open(kLibraryXML, std::strlen(kLibraryXML), "library.xml"));
+    BOOST_CHECK_EQUAL(readAll(reader), kLibraryEvents);
+    BOOST_CHECK(!reader.failed());
+    
+    std::istringstream stream(kLibraryXML);
+    BOOST_CHECK(reader.open(stream, "library.xml"));
+    BOOST_CHECK_EQUAL(readAll(reader), kLibraryEvents);
+    BOOST_CHECK(!reader.failed());
+}
+
+BOOST_AUTO_TEST_CASE(xmlReaderDepthTest) {
+    XmlReader reader;
+    reader.open(kLibraryXML, std::strlen(kLibraryXML), "library.xml");
+    BOOST_CHECK(reader.read());
+    BOOST_CHECK(reader.event() == XmlEvent::StartElement);
+    BOOST_CHECK_EQUAL(reader.depth(), 0u);
+    BOOST_CHECK(reader.read());
+    BOOST_CHECK(reader.event() == XmlEvent::Text);
+    BOOST_CHECK_EQUAL(reader.depth(), 1u);
+    BOOST_CHECK(reader.read());
+    BOOST_CHECK_EQUAL(reader.name().localName(), std::string("book"));
+    BOOST_CHECK_EQUAL(reader.depth(), 1u);
+}
+
+/**
+ Read the titles of all books, skipping everything else.
+ */
+static std::string readTitles(XmlReader& reader) {
+    std::string titles;
+    while (reader.read()) {
+        if (reader.event() != XmlEvent::StartElement || reader.depth() != 2)
+            continue;
+        
+        std::string_view text;
+        if (std::strcmp(reader.name().localName(), "title") == 0) {
+            BOOST_CHECK(reader.readElementText(text));
+            titles += std::string(text) + ";";
+        } else {
+            BOOST_CHECK(reader.skipSubtree());
+        }
+        BOOST_CHECK(reader.event() == XmlEvent::EndElement);
+        BOOST_CHECK_EQUAL(reader.depth(), 2u);
+    }
+    return titles;
+}
+
+BOOST_AUTO_TEST_CASE(xmlReaderSkipTest) {
+    XmlReader reader;
+    reader.open(kLibraryXML, std::strlen(kLibraryXML), "library.xml");
+    BOOST_CHECK_EQUAL(readTitles(reader), "One;Two;");
+    
+    // Large documents span many chunks, skipping happens inside libxml2
+    std::string xml = "<library>";
+    std::string allText;
+    for (int i = 0; i < 2000; ++i) {
+        std::string title = "T" + std::to_string(i);
+        xml += "<book><title>" + title + "</title><notes>";
+        allText += title;
+        for (int j = 0; j < 20; ++j) {
+            xml += "<p class='x'>some notes to skip</p>";
+            allText += "some notes to skip";
+        }
+        xml += "</notes></book>";
+    }
+    xml += "</library>";
+    
+    reader.open(xml.data(), xml.size(), "large.xml");
+    std::string titles = readTitles(reader);
+    BOOST_CHECK(!reader.failed());
+    BOOST_CHECK_EQUAL(std::count(titles.begin(), titles.end(), ';'), 2000);
+    BOOST_CHECK(titles.compare(0, 6, "T0;T1;") == 0);
+    
+    // Element text spanning chunks is joined
+    reader.open(xml.data(), xml.size(), "large.xml");
+    BOOST_CHECK(reader.read());
+    std::string_view text;
+    BOOST_CHECK(reader.readElementText(text));
+    BOOST_CHECK(text == allText);
+    BOOST_CHECK(!reader.read());
+}
+
+BOOST_AUTO_TEST_CASE(xmlReaderErrorTest) {
+    static const char* kInvalidXML = "<a><b>text</a>";
+    XmlReader reader;
+    reader.open(kInvalidXML, std::strlen(kInvalidXML), "invalid.xml");
+    while (reader.read()) {}
+    BOOST_CHECK(reader.failed());
+    BOOST_CHECK(!reader.skipSubtree());
+}